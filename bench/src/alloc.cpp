@@ -0,0 +1,49 @@
+#include "bench.h"
+#include <cstdlib>
+#include <new>
+
+// Replaces the global allocation functions to count allocations. The array and nothrow forms
+// call these by default, so they are counted too.
+
+void* operator new(std::size_t size)
+{
+  bench::allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* p = std::malloc(size ? size : 1)) return p;
+  throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+  bench::allocations.fetch_add(1, std::memory_order_relaxed);
+  const std::size_t align = static_cast<std::size_t>(alignment);
+#ifdef _WIN32
+  if (void* p = _aligned_malloc(size ? size : 1, align)) return p;
+#else
+  if (void* p = std::aligned_alloc(align, (std::max<std::size_t>(size, 1) + align - 1) / align * align)) return p;
+#endif
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+  std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+  std::free(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept
+{
+#ifdef _WIN32
+  _aligned_free(p);
+#else
+  std::free(p);
+#endif
+}
+
+void operator delete(void* p, std::size_t, std::align_val_t alignment) noexcept
+{
+  operator delete(p, alignment);
+}
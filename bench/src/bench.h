@@ -0,0 +1,94 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace bench
+{
+  // Calls to operator new since the program started, counted by the replacement in alloc.cpp
+  inline std::atomic<std::uint64_t> allocations {0};
+
+  // Keeps the optimizer from discarding a benchmarked result
+  template<typename T>
+  inline void keep(const T& value)
+  {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r"(&value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+    (void)sink;
+#endif
+  }
+
+  // Runs fn `iterations` times and prints the mean time per call, the allocations per call and the
+  // 99th percentile. Calls are timed in batches (of one call for slow benchmarks), so the percentile
+  // is over batch means and doesn't measure the clock itself.
+  template<typename Fn>
+  inline double run(const char* name, std::size_t iterations, Fn&& fn)
+  {
+    for (std::size_t i = 0; i < iterations / 10 + 1; ++i) fn(i); // Warm up
+    const std::size_t batch = std::max<std::size_t>(1, iterations / 1000);
+    std::vector<double> samples;
+    samples.reserve(iterations / batch + 1);
+    const std::uint64_t allocated = allocations.load(std::memory_order_relaxed);
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < iterations;)
+    {
+      const std::size_t count = std::min(batch, iterations - i);
+      auto batchStart = std::chrono::steady_clock::now();
+      for (const std::size_t end = i + count; i < end; ++i) fn(i);
+      samples.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - batchStart).count() / count);
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    const double allocs = static_cast<double>(allocations.load(std::memory_order_relaxed) - allocated) / iterations;
+    const double ns = elapsed.count() / iterations;
+    std::sort(samples.begin(), samples.end());
+    const double p99 = samples[std::min(samples.size() - 1, samples.size() * 99 / 100)];
+    std::printf("%-48s %12.1f ns/op %8.2f allocs/op %12.1f ns p99\n", name, ns, allocs, p99);
+    return ns;
+  }
+
+  // Writes `content` to <temp>/i18n-bench/<locale>.locale and returns the directory
+  inline std::filesystem::path writeLocale(const std::string& locale, const std::string& content)
+  {
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "i18n-bench";
+    std::filesystem::create_directories(dir);
+    std::ofstream(dir / (locale + ".locale"), std::ios::binary) << content;
+    return dir;
+  }
+
+  // Shape of the synthetic catalogs, set from the command line (see main.cpp)
+  struct catalog_options
+  {
+    std::size_t keys = 10000;
+    std::size_t namespaces = 8; // The first one is the default namespace
+    std::size_t valueLength = 32; // Characters per msgstr, before its "{}" field
+    double utf8 = 0.5; // Share of msgstr characters that are 3-byte UTF-8 (CJK), the rest is ASCII
+  };
+
+  inline catalog_options options;
+
+  struct catalog
+  {
+    std::string content; // The locale file
+    std::vector<std::string> namespaces; // Of each key
+    std::vector<std::string> msgids;
+  };
+
+  // Every msgstr ends with a "{}" field, so the same keys serve formatted lookups. The keys only depend
+  // on options and the values also on seed, so two seeds give two locales of the same program.
+  catalog generateCatalog(const catalog_options& options, std::uint64_t seed = 1);
+
+  void format();
+  void parse();
+  void lookup();
+  void translate();
+  void locale();
+}
@@ -0,0 +1,42 @@
+#include "bench.h"
+
+bench::catalog bench::generateCatalog(const catalog_options& options, std::uint64_t seed)
+{
+  std::uint64_t state = seed * 0x9e3779b97f4a7c15ull + 1;
+  auto random = [&state] { // xorshift64*
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 0x2545f4914f6cdd1dull;
+  };
+
+  catalog generated;
+  generated.namespaces.reserve(options.keys);
+  generated.msgids.reserve(options.keys);
+  generated.content.reserve(options.keys * (48 + options.valueLength * (1 + 2 * options.utf8)));
+  const std::uint64_t utf8Threshold = static_cast<std::uint64_t>(options.utf8 * 1000);
+  for (std::size_t i = 0; i < options.keys; ++i)
+  {
+    const std::size_t ns = options.namespaces ? i % options.namespaces : 0;
+    generated.namespaces.push_back(ns ? "namespace" + std::to_string(ns) : "default");
+    generated.msgids.push_back("Message key number " + std::to_string(i));
+
+    std::string value;
+    for (std::size_t c = 0; c < options.valueLength; ++c)
+    {
+      const std::uint64_t r = random();
+      if (r % 1000 < utf8Threshold)
+      {
+        const std::uint32_t cp = 0x4e00 + static_cast<std::uint32_t>((r >> 16) % 0x5000); // CJK Unified Ideographs
+        value += static_cast<char>(0xe0 | (cp >> 12));
+        value += static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+        value += static_cast<char>(0x80 | (cp & 0x3f));
+      }
+      else
+        value += "abcdefghijklmnopqrstuvwxyz      "[(r >> 16) % 32];
+    }
+    // The namespace is written for every entry, "default" being the default namespace
+    generated.content += "ns: " + generated.namespaces.back() + "\nmsgid: " + generated.msgids.back() + "\nmsgstr: " + value + " {}\n\n";
+  }
+  return generated;
+}
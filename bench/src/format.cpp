@@ -0,0 +1,45 @@
+#include "bench.h"
+#include <i18n/i18n.h>
+
+// Pre-parsed format strings (i18n::Translate) against formatting the raw msgstr on every call. Only "{}"
+// and "{:.Nf}" fields are pre-parsed, a msgstr with any other field takes the vformat fallback.
+void bench::format()
+{
+  std::filesystem::path dir = writeLocale("zh-CN",
+    "msgid: counter = {}\n"
+    "msgstr: 计数器 = {}\n\n"
+    "msgid: counter = {:d}\n"
+    "msgstr: 计数器 = {:d}\n\n"
+    "msgid: Application average {:.3f} ms/frame ({:.1f} FPS)\n"
+    "msgstr: 应用程序平均{:.3f}毫秒/帧（{:.1f}FPS）。\n\n"
+    "msgid: You catched {0} carrots in {1} seconds\n"
+    "msgstr: 你在{1}秒内抓到了{0}根胡萝卜\n");
+  i18n::Init(dir, "zh-CN");
+
+  const std::size_t iterations = 1000000;
+  std::printf("\n== format ==\n");
+  run("pre-parsed   counter = {}", iterations, [](std::size_t i) {
+    keep(i18n::Translate("counter = {}", static_cast<int>(i)));
+  });
+  run("vformat      counter = {}", iterations, [](std::size_t i) {
+    int counter = static_cast<int>(i);
+    keep(i18n_vformat(i18n::TranslateView("counter = {}"), i18n_make_format_args(counter)));
+  });
+  run("fallback     counter = {:d}", iterations, [](std::size_t i) {
+    keep(i18n::Translate("counter = {:d}", static_cast<int>(i)));
+  });
+  run("pre-parsed   Application average ...", iterations, [](std::size_t i) {
+    keep(i18n::Translate("Application average {:.3f} ms/frame ({:.1f} FPS)", 16.6f + i % 7, 60.0f));
+  });
+  run("vformat      Application average ...", iterations, [](std::size_t i) {
+    float ms = 16.6f + i % 7, fps = 60.0f;
+    keep(i18n_vformat(i18n::TranslateView("Application average {:.3f} ms/frame ({:.1f} FPS)"), i18n_make_format_args(ms, fps)));
+  });
+  run("pre-parsed   You catched {0} carrots ...", iterations, [](std::size_t i) {
+    keep(i18n::Translate("You catched {0} carrots in {1} seconds", static_cast<int>(i), 2));
+  });
+  run("vformat      You catched {0} carrots ...", iterations, [](std::size_t i) {
+    int carrots = static_cast<int>(i), seconds = 2;
+    keep(i18n_vformat(i18n::TranslateView("You catched {0} carrots in {1} seconds"), i18n_make_format_args(carrots, seconds)));
+  });
+}
@@ -0,0 +1,45 @@
+#include "bench.h"
+#include <i18n/i18n.h>
+
+// Init and SetLocale latency with two synthetic locales of the same program
+void bench::locale()
+{
+  std::filesystem::path dir = writeLocale("xx-A", generateCatalog(options, 1).content);
+  writeLocale("xx-B", generateCatalog(options, 2).content);
+  const std::filesystem::path compiledA = dir / "xx-A.localec", compiledB = dir / "xx-B.localec";
+
+  const std::size_t iterations = 50;
+  std::printf("\n== locale (%zu keys) ==\n", options.keys);
+  run("Init, text", iterations, [&](std::size_t) {
+    i18n::Init(dir, "xx-A", "xx-A");
+  });
+  i18n::Init(dir, "xx-A", "xx-A");
+  run("SetLocale, text", iterations, [&](std::size_t i) {
+    i18n::SetLocale(i % 2 ? "xx-A" : "xx-B");
+  });
+
+  i18n::CompileLocale(dir / "xx-A.locale", compiledA);
+  i18n::CompileLocale(dir / "xx-B.locale", compiledB);
+  run("Init, compiled", iterations, [&](std::size_t) {
+    i18n::Init(dir, "xx-A", "xx-A");
+  });
+  i18n::Init(dir, "xx-A", "xx-A");
+  run("SetLocale, compiled", iterations, [&](std::size_t i) {
+    i18n::SetLocale(i % 2 ? "xx-A" : "xx-B");
+  });
+  i18n::SetLocaleCacheSize(2);
+  i18n::Init(dir, "xx-A", "xx-A");
+  run("SetLocale, compiled, cached", iterations, [&](std::size_t i) {
+    i18n::SetLocale(i % 2 ? "xx-A" : "xx-B");
+  });
+  i18n::SetLocaleCacheSize(0);
+  std::filesystem::remove(compiledA);
+  std::filesystem::remove(compiledB);
+
+  i18n::SetLocaleCacheSize(2);
+  i18n::Init(dir, "xx-A", "xx-A");
+  run("SetLocale, text, cached", iterations, [&](std::size_t i) {
+    i18n::SetLocale(i % 2 ? "xx-A" : "xx-B");
+  });
+  i18n::SetLocaleCacheSize(0);
+}
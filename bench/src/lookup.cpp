@@ -0,0 +1,109 @@
+#include "bench.h"
+#include <i18n/i18n.h>
+#include <vector>
+
+// The same label looked up the ways the example's UI code could do it every frame
+void bench::lookup()
+{
+  writeLocale("en-US",
+    "msgid: Hello, world!\n"
+    "msgstr: Hello, world!\n\n"
+    "msgid: Settings\n"
+    "msgstr: Settings\n");
+  std::filesystem::path dir = writeLocale("zh-CN",
+    "msgid: Hello, world!\n"
+    "msgstr: 你好，世界！\n\n"
+    "ns: ns1\n"
+    "msgid: Back\n"
+    "msgstr: 返回\n");
+  i18n::Init(dir, "zh-CN");
+
+  const std::size_t iterations = 10000000;
+  std::printf("\n== lookup ==\n");
+  run("TranslateView(\"Hello, world!\")", iterations, [](std::size_t) {
+    keep(i18n::TranslateView("Hello, world!"));
+  });
+  run("TranslateView(\"Hello, world!\"_i18n)", iterations, [](std::size_t) {
+    keep(i18n::TranslateView("Hello, world!"_i18n));
+  });
+  run("I18N(\"Hello, world!\")", iterations, [](std::size_t) {
+    keep(I18N("Hello, world!"));
+  });
+  run("TranslateView(\"Settings\") (default locale)", iterations, [](std::size_t) {
+    keep(i18n::TranslateView("Settings"));
+  });
+  run("TranslateNView(\"ns1\", \"Back\")", iterations, [](std::size_t) {
+    keep(i18n::TranslateNView("ns1", "Back"));
+  });
+  run("I18N_N(\"ns1\", \"Back\")", iterations, [](std::size_t) {
+    keep(I18N_N("ns1", "Back"));
+  });
+
+  // What message-extractor generates for the two messages above
+  static constexpr i18n::key messageTable[] = {i18n::key("Hello, world!"), i18n::key("ns1", "Back")};
+  i18n::RegisterMessageTable(messageTable);
+  run("TranslateView(message_id)", iterations, [](std::size_t) {
+    keep(i18n::TranslateView(i18n::message_id{1}));
+  });
+
+  // Three levels above the default locale, the lookup should cost the same
+  writeLocale("zh-Hant-TW", "msgid: Back\nmsgstr: 返回\n");
+  writeLocale("zh-Hant", "msgid: Hello, world!\nmsgstr: 你好，世界！\n");
+  writeLocale("zh", "msgid: Hello, world!\nmsgstr: 你好，世界！\n");
+  i18n::SetLocale("zh-Hant-TW");
+  run("TranslateView(\"Settings\") (4 levels, text)", iterations, [](std::size_t) {
+    keep(i18n::TranslateView("Settings"));
+  });
+  const char* chain[] = {"zh-Hant-TW", "zh-Hant", "zh", "en-US"};
+  for (const char* locale : chain) i18n::CompileLocale(dir / (std::string(locale) + ".locale"), dir / (std::string(locale) + ".localec"));
+  i18n::Init(dir, "zh-Hant-TW");
+  run("TranslateView(\"Settings\") (4 levels, compiled)", iterations, [](std::size_t) {
+    keep(i18n::TranslateView("Settings"));
+  });
+  for (const char* locale : chain) std::filesystem::remove(dir / (std::string(locale) + ".localec"));
+  // Lazily loaded chains aren't merged, this one probes all four files
+  i18n::SetLazyNamespaces(true);
+  i18n::Init(dir, "zh-Hant-TW");
+  run("TranslateView(\"Settings\") (4 levels, lazy)", iterations, [](std::size_t) {
+    keep(i18n::TranslateView("Settings"));
+  });
+  i18n::SetLazyNamespaces(false);
+
+  // A large catalog, once from text (probed slot table) and once compiled (minimal perfect hash).
+  // Keys are visited in a scattered order so the slots don't stay in cache.
+  const std::size_t entries = 100000;
+  std::string content;
+  std::vector<std::string> namespaces, msgids;
+  for (std::size_t i = 0; i < entries; ++i)
+  {
+    namespaces.push_back("ns" + std::to_string(i % 16));
+    msgids.push_back("Message number " + std::to_string(i));
+    content += "ns: " + namespaces.back() + "\nmsgid: " + msgids.back() + "\nmsgstr: Translated message " + std::to_string(i) + "\n\n";
+  }
+  dir = writeLocale("xx-LARGE", content);
+  std::vector<i18n::key> hits, misses;
+  for (std::size_t i = 0; i < entries; ++i)
+  {
+    hits.emplace_back(namespaces[i], msgids[i]);
+    misses.emplace_back("missing", msgids[i]);
+  }
+  auto large = [&](const char* layout) {
+    std::string name;
+    name = std::string("TranslateView(key) 100k entries, ") + layout;
+    run(name.c_str(), iterations, [&](std::size_t i) {
+      keep(i18n::TranslateView(hits[i * 7919 % entries]));
+    });
+    name = std::string("TranslateView(key) 100k entries, miss, ") + layout;
+    run(name.c_str(), iterations, [&](std::size_t i) {
+      keep(i18n::TranslateView(misses[i * 7919 % entries]));
+    });
+  };
+  i18n::Init(dir, "xx-LARGE", "xx-LARGE");
+  large("text");
+  std::filesystem::path compiled = dir / "xx-LARGE.localec";
+  i18n::CompileLocale(dir / "xx-LARGE.locale", compiled);
+  i18n::Init(dir, "xx-LARGE", "xx-LARGE");
+  large("compiled");
+  i18n::Init(dir, "zh-CN");
+  std::filesystem::remove(compiled);
+}
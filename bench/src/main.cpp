@@ -0,0 +1,36 @@
+#include "bench.h"
+#include <cstdlib>
+#include <cstring>
+
+// Usage: bench [--keys <n>] [--namespaces <n>] [--value-length <n>] [--utf8 <share>] [<suite>...]
+//
+// Suites: lookup, translate, format, parse, locale. All of them run if none is given. The options shape
+// the synthetic catalogs of translate, parse and locale.
+int main(int argc, char** argv)
+{
+  std::vector<std::string> suites;
+  for (int i = 1; i < argc; ++i)
+  {
+    if (!std::strcmp(argv[i], "--keys") && i + 1 < argc)
+      bench::options.keys = std::strtoull(argv[++i], nullptr, 10);
+    else if (!std::strcmp(argv[i], "--namespaces") && i + 1 < argc)
+      bench::options.namespaces = std::strtoull(argv[++i], nullptr, 10);
+    else if (!std::strcmp(argv[i], "--value-length") && i + 1 < argc)
+      bench::options.valueLength = std::strtoull(argv[++i], nullptr, 10);
+    else if (!std::strcmp(argv[i], "--utf8") && i + 1 < argc)
+      bench::options.utf8 = std::strtod(argv[++i], nullptr);
+    else
+      suites.push_back(argv[i]);
+  }
+
+  const std::pair<const char*, void (*)()> all[] = {
+    {"lookup", bench::lookup},
+    {"translate", bench::translate},
+    {"format", bench::format},
+    {"parse", bench::parse},
+    {"locale", bench::locale},
+  };
+  for (const auto& [name, suite] : all)
+    if (suites.empty() || std::find(suites.begin(), suites.end(), name) != suites.end()) suite();
+  return 0;
+}
@@ -0,0 +1,22 @@
+#include "bench.h"
+#include <i18n/i18n.h>
+
+// Text catalog parsing throughput on a synthetic million-entry catalog
+void bench::parse()
+{
+  catalog_options large = options; // Same shape as the other benchmarks, but a million keys
+  large.keys = 1000000;
+  const std::string content = generateCatalog(large).content;
+  std::filesystem::path dir = writeLocale("en-US", content);
+
+  std::printf("\n== parse ==\n");
+  const std::size_t iterations = 5;
+  for (std::size_t threads : {1, 2, 4, 8, 16, 32}) // Scaling of SetParseThreads
+  {
+    i18n::SetParseThreads(threads);
+    std::string name = "Init, 1M entries from text, " + std::to_string(threads) + " thread(s)";
+    double ns = run(name.c_str(), iterations, [&](std::size_t) { i18n::Init(dir); });
+    std::printf("%-48s %12.1f MB/s\n", "", content.size() / (ns / 1e9) / 1e6);
+  }
+  i18n::SetParseThreads(1);
+}
@@ -0,0 +1,52 @@
+#include "bench.h"
+#include <i18n/i18n.h>
+
+// Lookups on a synthetic catalog shaped by the command line options. Keys are visited in a scattered
+// order, so a large catalog isn't served from cache.
+void bench::translate()
+{
+  const catalog generated = generateCatalog(options);
+  std::filesystem::path dir = writeLocale("xx-SYN", generated.content);
+  i18n::Init(dir, "xx-SYN", "xx-SYN");
+
+  std::vector<std::size_t> defaultKeys; // Keys in the default namespace, for the lookups without one
+  for (std::size_t i = 0; i < generated.msgids.size(); ++i)
+    if (generated.namespaces[i] == "default") defaultKeys.push_back(i);
+  std::vector<std::string> missing;
+  for (std::size_t i = 0; i < 4096; ++i) missing.push_back("Missing key number " + std::to_string(i));
+  if (defaultKeys.empty()) return;
+
+  auto scatter = [](std::size_t i, std::size_t size) { return i * 7919 % size; };
+  const std::size_t iterations = 2000000;
+  std::printf("\n== translate (%zu keys, %zu namespaces, %zu chars, %.0f%% UTF-8) ==\n", options.keys, options.namespaces, options.valueLength, options.utf8 * 100);
+  run("Translate, hit", iterations, [&](std::size_t i) {
+    keep(i18n::Translate(generated.msgids[defaultKeys[scatter(i, defaultKeys.size())]]));
+  });
+  run("Translate, miss", iterations, [&](std::size_t i) {
+    keep(i18n::Translate(missing[i % missing.size()]));
+  });
+  run("TranslateView, hit", iterations, [&](std::size_t i) {
+    keep(i18n::TranslateView(generated.msgids[defaultKeys[scatter(i, defaultKeys.size())]]));
+  });
+  run("TranslateView, miss", iterations, [&](std::size_t i) {
+    keep(i18n::TranslateView(missing[i % missing.size()]));
+  });
+  run("TranslateN, hit", iterations, [&](std::size_t i) {
+    const std::size_t key = scatter(i, generated.msgids.size());
+    keep(i18n::TranslateN(generated.namespaces[key], generated.msgids[key]));
+  });
+  run("TranslateNView, hit", iterations, [&](std::size_t i) {
+    const std::size_t key = scatter(i, generated.msgids.size());
+    keep(i18n::TranslateNView(generated.namespaces[key], generated.msgids[key]));
+  });
+  run("TranslateNView, miss", iterations, [&](std::size_t i) {
+    keep(i18n::TranslateNView("namespace1", missing[i % missing.size()]));
+  });
+  run("Translate, hit, formatted", iterations, [&](std::size_t i) {
+    keep(i18n::Translate(generated.msgids[defaultKeys[scatter(i, defaultKeys.size())]], static_cast<int>(i)));
+  });
+  char buffer[256];
+  run("TranslateToBuffer, hit, formatted", iterations, [&](std::size_t i) {
+    keep(i18n::TranslateToBuffer(buffer, generated.msgids[defaultKeys[scatter(i, defaultKeys.size())]], static_cast<int>(i)));
+  });
+}
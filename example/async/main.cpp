@@ -0,0 +1,74 @@
+// Headless companion of the ImGui example: a "UI" thread keeps the views it gets from I18N and
+// TranslateView for a whole frame while locales are switched with SetLocaleAsync, from the UI thread
+// and from another thread. It calls i18n::Poll() at the start of every frame, so each view must still
+// read as one of its key's translations at the end of the frame. Build it with a sanitizer to check
+// that nothing it reads has been freed:
+//
+//   xmake f -m debug --policies=build.sanitizer.address   (or build.sanitizer.thread)
+//   xmake build async-example && xmake run async-example [seconds]
+//
+// Exits with 1 if a view changed under the frame.
+
+#include <i18n/i18n.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+static const char* locales[] = {"en-US", "zh-CN", "ja-JP"};
+
+int main(int argc, char** argv)
+{
+    const int seconds = argc > 1 ? std::atoi(argv[1]) : 3;
+    i18n::Init("example/locales");
+    i18n::SetLocaleCacheSize(0); // Every switch loads and frees a locale
+
+    // Every translation each label may show
+    std::vector<std::vector<std::string>> expected(5);
+    for (const char* locale : locales)
+    {
+        i18n::SetLocale(locale);
+        expected[0].emplace_back(i18n::TranslateView("Hello, world!"));
+        expected[1].emplace_back(i18n::TranslateView("Button"));
+        expected[2].emplace_back(i18n::TranslateNView("ns1", "Back"));
+        expected[3].emplace_back(i18n::TranslateNView("ns2", "Back"));
+        expected[4].emplace_back(i18n::TranslateView("Another Window"));
+    }
+
+    std::atomic<bool> stop {false};
+    std::thread switcher([&stop] {
+        for (std::size_t i = 0; !stop; ++i)
+            i18n::SetLocaleAsync(locales[i % 3]).wait();
+    });
+
+    std::size_t frames = 0, changed = 0;
+    const auto end = std::chrono::steady_clock::now() + std::chrono::seconds(seconds);
+    while (std::chrono::steady_clock::now() < end)
+    {
+        i18n::Poll(); // Nothing from the last frame is used any more
+
+        const std::string_view views[] = {
+            I18N("Hello, world!"),
+            i18n::TranslateView("Button"),
+            I18N_N("ns1", "Back"),
+            i18n::TranslateNView("ns2", "Back"),
+            i18n::TranslateView("Another Window"_i18n),
+        };
+        if (frames % 5 == 0)
+            i18n::SetLocaleAsync(locales[frames % 3]); // Published while this frame still uses its views
+        std::this_thread::sleep_for(std::chrono::microseconds(500)); // Rendering
+
+        for (std::size_t label = 0; label < std::size(views); ++label)
+            if (std::find(expected[label].begin(), expected[label].end(), views[label]) == expected[label].end())
+                ++changed;
+        ++frames;
+    }
+    stop = true;
+    switcher.join();
+
+    std::printf("%zu frames, %zu views changed under the frame\n", frames, changed);
+    return changed ? 1 : 0;
+}
@@ -8,6 +8,10 @@
 #include "imgui_impl/imgui_impl_opengl3.h"
 #include <stdio.h>
 #include <i18n/i18n.h>
+#ifdef I18N_EMBED_LOCALES // xmake f --embed_locales=y: the locales are linked in, not read from the locales directory
+#include <ja-JP.locale.h>
+#include <zh-CN.locale.h>
+#endif
 
 #if defined(IMGUI_IMPL_OPENGL_ES2)
 #include <GLES2/gl2.h>
@@ -58,7 +62,6 @@ static void changelocale(bool& change_locale,ImGuiIO& io, std::string locale)
         io.Fonts->AddFontFromFileTTF("C:\\Windows\\Fonts\\meiryo.ttc", 15.0f, NULL, io.Fonts->GetGlyphRangesJapanese());
     io.Fonts->Build();
     ImGui_ImplOpenGL3_CreateFontsTexture();
-    i18n::SetLocale(locale);
     change_locale = false;
 }
 
@@ -166,6 +169,7 @@ int main(int, char**)
     
     bool change_locale {false};
     std::string locale {"en-US"};
+    std::future<void> locale_loaded; // The locale is parsed in the background, the font is switched once it is ready
     // Initialize i18n
     i18n::Init();
 
@@ -179,8 +183,12 @@ int main(int, char**)
         // Generally you may always pass all inputs to dear imgui, and hide them from your application based on those two flags.
         glfwPollEvents();
 
+        // The labels of the last frame have been drawn. Views from I18N stay valid until the next Poll,
+        // even when SetLocaleAsync publishes a locale in the middle of the frame.
+        i18n::Poll();
+
         // Change font and locale
-        if (change_locale)
+        if (change_locale && locale_loaded.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
             changelocale(change_locale, io, locale);
 
         // Start the Dear ImGui frame
@@ -197,36 +205,40 @@ int main(int, char**)
             static float f = 0.0f;
             static int counter = 0;
 
-            ImGui::Begin(i18n::Translate("Hello, world!").c_str(), NULL, ImGuiWindowFlags_AlwaysAutoResize);                          // Create a window called "Hello, world!" and append into it.
+            ImGui::Begin(I18N("Hello, world!").data(), NULL, ImGuiWindowFlags_AlwaysAutoResize);                          // Create a window called "Hello, world!" and append into it.
 
-            ImGui::Text(i18n::Translate("This is some useful text.").c_str());               // Display some text (you can use a format strings too)
+            ImGui::Text(I18N("This is some useful text.").data());               // Display some text (you can use a format strings too)
             // ImGui::Checkbox("Demo Window", &show_demo_window);      // Edit bools storing our window open/close state
-            ImGui::Checkbox(i18n::Translate("Another Window").c_str(), &show_another_window);
+            ImGui::Checkbox(I18N("Another Window").data(), &show_another_window);
 
-            ImGui::SliderFloat(i18n::Translate("float").c_str(), &f, 0.0f, 1.0f);            // Edit 1 float using a slider from 0.0f to 1.0f
-            ImGui::ColorEdit3(i18n::Translate("clear color").c_str(), (float*)&clear_color); // Edit 3 floats representing a color
+            ImGui::SliderFloat(I18N("float").data(), &f, 0.0f, 1.0f);            // Edit 1 float using a slider from 0.0f to 1.0f
+            ImGui::ColorEdit3(I18N("clear color").data(), (float*)&clear_color); // Edit 3 floats representing a color
 
-            if (ImGui::Button(i18n::Translate("Button").c_str()))                            // Buttons return true when clicked (most widgets return true when edited/activated)
+            if (ImGui::Button(I18N("Button").data()))                            // Buttons return true when clicked (most widgets return true when edited/activated)
                 counter++;
             ImGui::SameLine();
-            ImGui::Text(i18n::Translate("counter = {:d}", counter).c_str());
-            ImGui::Text(i18n::TranslateN("ns1", "Back").c_str());
-            ImGui::Text(i18n::TranslateN("ns2", "Back").c_str());
+            char label[256]; // Reused for formatted translations, so they don't allocate
+            ImGui::TextUnformatted(label, i18n::TranslateToBuffer(label, "counter = {:d}", counter).out);
+            ImGui::Text(I18N_N("ns1", "Back").data());
+            ImGui::Text(I18N_N("ns2", "Back").data());
 
-            ImGui::Text(i18n::Translate("Application average {:.3f} ms/frame ({:.1f} FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate).c_str());
-            if (ImGui::Button(i18n::Translate("Switch to English..").c_str()) && locale != "en-US")
+            ImGui::TextUnformatted(label, i18n::TranslateToBuffer(label, "Application average {:.3f} ms/frame ({:.1f} FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate).out);
+            if (ImGui::Button(I18N("Switch to English..").data()) && locale != "en-US")
             {
                 locale = "en-US";
+                locale_loaded = i18n::SetLocaleAsync(locale);
                 change_locale = true;
             }
-            if (ImGui::Button(i18n::Translate("Switch to Chinese..").c_str()) && locale != "zh-CN")
+            if (ImGui::Button(I18N("Switch to Chinese..").data()) && locale != "zh-CN")
             {
                 locale = "zh-CN";
+                locale_loaded = i18n::SetLocaleAsync(locale);
                 change_locale = true;
             }
-            if (ImGui::Button(i18n::Translate("Switch to Japanese..").c_str()) && locale != "ja-JP")
+            if (ImGui::Button(I18N("Switch to Japanese..").data()) && locale != "ja-JP")
             {
                 locale = "ja-JP";
+                locale_loaded = i18n::SetLocaleAsync(locale);
                 change_locale = true;
             }
             ImGui::End();
@@ -235,9 +247,9 @@ int main(int, char**)
         // 3. Show another simple window.
         if (show_another_window)
         {
-            ImGui::Begin(i18n::Translate("Another Window").c_str(), &show_another_window);   // Pass a pointer to our bool variable (the window will have a closing button that will clear the bool when clicked)
-            ImGui::Text(i18n::Translate("Hello from another window!").c_str());
-            if (ImGui::Button(i18n::Translate("Close Me").c_str()))
+            ImGui::Begin(I18N("Another Window").data(), &show_another_window);   // Pass a pointer to our bool variable (the window will have a closing button that will clear the bool when clicked)
+            ImGui::Text(I18N("Hello from another window!").data());
+            if (ImGui::Button(I18N("Close Me").data()))
                 show_another_window = false;
             ImGui::End();
         }
@@ -1,20 +1,417 @@
 #pragma once
 #include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cassert>
+#include <atomic>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <algorithm>
 #include <unordered_map>
+#include <iterator>
+#include <charconv>
+#include <type_traits>
+#if __has_include(<version>)
+#include <version>
+#endif
+#ifdef __cpp_lib_span
+#include <span>
+#endif
+#include <cstring>
 #include <fstream>
 #include <filesystem>
+#include <thread>
+#include <exception>
+#include <limits>
+#include <utility>
+
+#ifdef _WIN32 // For mapping compiled catalogs
+#ifndef NOMINMAX
+#define NOMINMAX
+#define I18N_UNDEF_NOMINMAX
+#endif
+#include <windows.h>
+#ifdef I18N_UNDEF_NOMINMAX
+#undef NOMINMAX
+#undef I18N_UNDEF_NOMINMAX
+#endif
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__ // For hot reload
+#include <poll.h>
+#include <sys/inotify.h>
+#endif
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <xmmintrin.h>
+#define i18n_prefetch(address) _mm_prefetch(reinterpret_cast<const char*>(address), _MM_HINT_T0)
+#elif defined(__GNUC__) || defined(__clang__)
+#define i18n_prefetch(address) __builtin_prefetch(address)
+#else
+#define i18n_prefetch(address) ((void)(address))
+#endif
+
+#ifdef __cpp_consteval // C++17 (with {fmt}) has no consteval, _i18n keys are then only hashed at compile time in constant expressions
+#define i18n_consteval consteval
+#else
+#define i18n_consteval constexpr
+#endif
 
 #ifdef I18N_USE_FMT //Use fmt::format instead of c++20 std::format
 #include <fmt/core.h>
 #define i18n_format fmt::format
+#define i18n_vformat fmt::vformat
+#define i18n_vformat_to fmt::vformat_to
+#define i18n_make_format_args fmt::make_format_args
 #else
 #include <format>
 #define i18n_format std::format
+#define i18n_vformat std::vformat
+#define i18n_vformat_to std::vformat_to
+#define i18n_make_format_args std::make_format_args
 #endif
 
 class i18n
 {
-  typedef std::unordered_map<std::string, std::unordered_map<std::string, std::string>> dictionary;
+  // One piece of a pre-parsed format string: literal text, or a single replacement field re-encoded
+  // with an explicit argument index ("{1:.1f}") so it can be formatted on its own.
+  struct format_segment
+  {
+    enum kind : std::uint16_t { LITERAL, FIELD, DEFAULT, FIXED };
+    std::uint32_t offset, length; // Into the owning dictionary's strings
+    std::int32_t arg; // Argument index, -1 for literal text
+    kind kind; // DEFAULT is "{}", FIXED is "{:.Nf}", anything else is a FIELD
+    std::uint16_t precision; // For FIXED
+  };
+
+  // A resolved translation and its pre-parsed format string, if it has one
+  struct message
+  {
+    std::string_view msgstr; // data() is nullptr if there is no translation
+    const format_segment* format = nullptr; // nullptr if msgstr has to be formatted with vformat
+    std::uint32_t formatLen = 0;
+    const char* strings = nullptr; // Base of the segment offsets
+  };
+
+  // Read-only mapping of a whole file. Pages are shared between every process mapping the same file.
+  class mapped_file
+  {
+  public:
+    // With copy the file is read into memory instead, for a file that may be rewritten in place while
+    // in use: a mapping of it would fault (SIGBUS) once it's truncated.
+    explicit mapped_file(const std::filesystem::path& path, bool copy = false);
+    mapped_file(const char* data, std::size_t size) : m_data(data), m_size(size), m_borrowed(true) {} // Memory that outlives it, e.g. embedded in the binary
+    ~mapped_file();
+
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+
+    const char* data() const { return m_data; } // nullptr if the file couldn't be mapped
+    std::size_t size() const { return m_size; }
+
+  private:
+    const char* m_data = nullptr;
+    std::size_t m_size = 0;
+    bool m_borrowed = false;
+    std::unique_ptr<char[]> m_copy;
+  };
+
+  class lazy_index;
+  class resolved_table;
+
+  // Flat open-addressing table keyed by the combined (namespace, msgid) hash.
+  // Every string lives in one contiguous blob, slots only hold offsets into it.
+  class dictionary
+  {
+  public:
+    dictionary() = default;
+    // Owned storage is allocated from arena (the default resource if nullptr), which the dictionary keeps alive.
+    // Assigning another dictionary copies its entries into this one's arena unless they share it.
+    // Namespaces are always interned, internText also interns every msgid and msgstr (see seal).
+    explicit dictionary(std::shared_ptr<std::pmr::memory_resource> arena, bool internText = false) : m_arena(std::move(arena)), m_storage(m_arena ? m_arena.get() : std::pmr::get_default_resource()), m_internText(internText) {}
+    dictionary(const dictionary& other) : m_storage(other.m_storage), m_mapping(other.m_mapping), m_lazy(other.m_lazy), m_view(other.m_view), m_size(other.m_size), m_internText(other.m_internText), m_internedBytes(other.m_internedBytes) { rebind(); }
+    dictionary(dictionary&& other) noexcept : m_arena(std::move(other.m_arena)), m_storage(std::move(other.m_storage)), m_mapping(std::move(other.m_mapping)), m_lazy(std::move(other.m_lazy)), m_view(other.m_view), m_size(other.m_size), m_internText(other.m_internText), m_internedBytes(other.m_internedBytes) { rebind(); }
+    dictionary& operator=(dictionary other) noexcept;
+
+    void insert(std::string_view ns, std::string_view msgid, std::string_view msgstr); // Not for mapped dictionaries
+
+    void insert(std::uint64_t hash, std::string_view ns, std::string_view msgid, std::string_view msgstr); // hash is hashKey(ns, msgid)
+
+    // Starts loading the slot a hash starts probing at, so a bulk insert doesn't wait on each cache miss in turn
+    void prefetch(std::uint64_t hash) const { if (m_view.slotCount) i18n_prefetch(m_view.slots + (hash & (m_view.slotCount - 1))); }
+
+    void reserve(std::size_t entries, std::size_t stringBytes); // Avoids rehashing and string reallocation while parsing
+
+    // Appends every entry of other; on equal keys other's entry wins, as if its lines came after ours
+    void merge(const dictionary& other);
+
+    // msgstr.data() is nullptr if not found. Without verifyText a matching 64-bit hash is trusted in release builds.
+    message find(std::uint64_t hash, std::string_view ns, std::string_view msgid, bool verifyText = true) const;
+
+    std::size_t size() const; // A lazily loaded catalog counts the namespaces parsed so far
+
+    std::size_t indexedSize() const; // Every entry of a lazily loaded catalog, parsed or not; 0 for others
+
+    std::size_t stringsSize() const { return m_view.stringsSize; }
+
+    std::size_t bytes() const;
+
+    std::size_t internedBytes() const; // String bytes not stored because an identical string already was
+
+    bool mapped() const { return m_mapping != nullptr; }
+
+    // Drops the interning table once nothing more will be inserted. Strings are interned while
+    // inserting or merging, so text that repeats within the catalog is stored once.
+    void seal();
+
+    bool sameEntries(const dictionary& other) const; // Same keys with the same msgstr, however they are stored
+
+    void clear();
+
+    // Compiled catalog: the slots laid out by a minimal perfect hash, format segments and string blob,
+    // so loading is a few reads with no parsing or hashing and a lookup is a single probe. Files built
+    // with another default namespace are rejected.
+    bool save(const std::filesystem::path& path, std::string_view defaultNS) const;
+
+    bool load(const std::filesystem::path& path, std::string_view defaultNS);
+
+    // Zero-copy load: lookups read straight from a read-only mapping of the compiled catalog.
+    bool map(const std::filesystem::path& path, std::string_view defaultNS);
+
+    // Same over a compiled catalog image already in memory, which must outlive the dictionary.
+    bool map(const char* data, std::size_t size, std::string_view defaultNS);
+
+    // Lazy load of a text catalog: only a namespace index is built (or read from indexPath if that is
+    // not empty), and each namespace is parsed by the first lookup that needs it. See lazy_index.
+    // The file is mapped, or copied into memory with copy (see mapped_file).
+    bool openLazy(const std::filesystem::path& path, std::string_view defaultNS, const std::filesystem::path& indexPath, bool copy = false);
+
+  private:
+    friend class resolved_table;
+
+    struct file_header
+    {
+      char magic[8]; // "I18NCAT"
+      std::uint32_t version;
+      std::uint32_t byteOrder; // 0x01020304 as written by the compiler
+      std::uint64_t slotCount, size, formatCount, stringsSize;
+      std::uint32_t defaultNS, defaultNSLen; // In the string blob
+      std::uint64_t bucketCount; // Perfect hash displacements, 0 for an open-addressing slot table. Not in version 1.
+    };
+
+    static constexpr char fileMagic[8] = "I18NCAT";
+    static constexpr std::uint32_t fileVersion = 2;
+    static constexpr std::size_t fileHeaderSizeV1 = 56;
+
+    struct slot
+    {
+      std::uint64_t hash; // 0 marks an empty slot
+      std::uint32_t ns, nsLen;
+      std::uint32_t msgid, msgidLen;
+      std::uint32_t msgstr, msgstrLen;
+      std::uint32_t format, formatLen; // Range in the format segments, formatLen is 0 if msgstr wasn't pre-parsed
+    };
+
+    struct storage // Owned data while building, or after a non-mapped load
+    {
+      storage(std::pmr::memory_resource* resource = std::pmr::get_default_resource()) : slots(resource), strings(resource), format(resource), displacements(resource) {}
+
+      std::pmr::vector<slot> slots; // Capacity is always a power of two
+      std::pmr::string strings; // NUL-terminated strings, referenced by offset
+      std::pmr::vector<format_segment> format;
+      std::pmr::vector<std::uint32_t> displacements; // Only after loading a catalog compiled with a perfect hash
+    };
+
+    struct view // What lookups read, pointing into m_storage or m_mapping
+    {
+      const slot* slots = nullptr;
+      std::size_t slotCount = 0;
+      const format_segment* format = nullptr;
+      std::size_t formatCount = 0;
+      const char* strings = nullptr;
+      std::size_t stringsSize = 0;
+      // With a perfect hash the slots are dense (slotCount == size) and a key's slot is found through its
+      // bucket's displacement, see perfectSlot. Otherwise slotCount is a power of two and slots are probed.
+      const std::uint32_t* displacements = nullptr;
+      std::size_t bucketCount = 0;
+    };
+
+    std::shared_ptr<std::pmr::memory_resource> m_arena; // Outlives m_storage, nullptr for the default resource
+    storage m_storage;
+    std::shared_ptr<const mapped_file> m_mapping;
+    std::shared_ptr<const lazy_index> m_lazy; // Set for lazily loaded text catalogs, which have no slots of their own
+    view m_view;
+    std::size_t m_size = 0;
+    bool m_internText = false;
+    std::size_t m_internedBytes = 0;
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> m_interned; // {hash, offset + 1} of each string while inserting, 0 is empty
+    std::size_t m_internedCount = 0;
+
+    void rebind();
+
+    bool attach(const char* data, std::size_t size, std::string_view defaultNS); // Points m_view into a compiled catalog image
+
+    bool map(std::shared_ptr<const mapped_file> mapping, std::string_view defaultNS);
+
+    bool inStrings(std::uint64_t offset, std::uint64_t length) const { return offset + length < m_view.stringsSize; }
+
+    bool inBounds(const slot& s) const; // Every offset of the slot and its format segments is inside the catalog
+
+    message match(const slot& s, std::uint64_t hash, std::string_view ns, std::string_view msgid, bool verifyText) const; // msgstr.data() is nullptr if s isn't the key
+
+    // CHD-style minimal perfect hash: keys are split into buckets of about four by the low hash bits, and
+    // each bucket gets the first displacement that puts all of its keys in free slots. Buckets of one key
+    // are placed last, straight into a free slot (the top bit marks a direct slot index).
+    static std::size_t perfectBucket(std::uint64_t hash, std::size_t bucketCount) { return static_cast<std::size_t>(((hash & 0xffffffffu) * bucketCount) >> 32); }
+
+    static std::size_t perfectSlot(std::uint64_t hash, std::uint32_t displacement, std::size_t slotCount);
+
+    // positions[i] is the slot of hashes[i]. Fails on duplicate hashes, which only probing can tell apart.
+    static bool buildPerfectHash(const std::vector<std::uint64_t>& hashes, std::vector<std::uint32_t>& displacements, std::vector<std::uint32_t>& positions);
+
+    std::uint32_t addString(std::string_view str);
+
+    std::uint32_t internString(std::string_view str); // addString unless the same string was added already
+
+    void compileFormat(slot& slot);
+
+    void grow(std::size_t capacity);
+  };
+
+  // Byte ranges of each namespace's entries in a mapped text catalog. A namespace is parsed into its
+  // own dictionary by the first lookup that asks for it; after that lookups only load an atomic pointer.
+  // The index can be kept in a sidecar file, checked against the catalog's size and modification time.
+  class lazy_index
+  {
+  public:
+    // Parsed namespaces are allocated from arena and interned as internText says, see dictionary
+    static std::shared_ptr<const lazy_index> open(const std::filesystem::path& path, std::string_view defaultNS, const std::filesystem::path& indexPath, std::shared_ptr<std::pmr::memory_resource> arena, bool internText, bool copy);
+
+    message find(std::uint64_t hash, std::string_view ns, std::string_view msgid, bool verifyText) const;
+
+    std::size_t bytes() const; // The index plus the namespaces parsed so far
+
+    std::size_t size() const; // Entries of the namespaces parsed so far
+
+    std::size_t indexedSize() const; // Entries of all namespaces, as counted by the index
+
+    std::size_t internedBytes() const; // Of the namespaces parsed so far
+
+  private:
+    struct range { std::uint64_t begin, end; };
+
+    struct ns_entry
+    {
+      std::uint64_t hash; // hashString(name)
+      std::string name;
+      std::vector<range> ranges; // In file order, so later duplicates still win
+      std::uint64_t entries = 0; // msgstr records in the ranges, a key defined twice counts twice
+    };
+
+    struct index_header
+    {
+      char magic[8]; // "I18NIDX"
+      std::uint32_t version;
+      std::uint32_t byteOrder;
+      std::uint64_t textSize;
+      std::int64_t textTime; // last_write_time of the catalog
+      std::uint64_t namespaceCount, rangeCount, namesSize;
+      std::uint32_t defaultNSLen, reserved; // The default namespace starts the name blob
+    };
+
+    struct index_namespace
+    {
+      std::uint64_t hash;
+      std::uint32_t name, nameLen;
+      std::uint64_t firstRange, rangeCount;
+      std::uint64_t entries;
+    };
+
+    static constexpr char indexMagic[8] = "I18NIDX";
+    static constexpr std::uint32_t indexVersion = 2; // 2 added index_namespace::entries
+
+    std::shared_ptr<const mapped_file> m_mapping;
+    std::string m_defaultNS;
+    std::vector<ns_entry> m_namespaces; // Sorted by hash
+    std::unique_ptr<std::atomic<const dictionary*>[]> m_loaded;
+    std::shared_ptr<std::pmr::memory_resource> m_arena; // Only allocated from under m_mutex
+    bool m_internText = false;
+    mutable std::vector<std::unique_ptr<const dictionary>> m_owned; // Written under m_mutex
+    mutable std::mutex m_mutex;
+
+    void build(std::string_view text);
+
+    bool readIndex(const std::filesystem::path& indexPath, std::uint64_t textSize, std::int64_t textTime);
+
+    void writeIndex(const std::filesystem::path& indexPath, std::uint64_t textSize, std::int64_t textTime) const;
+
+    const dictionary& load(std::size_t index) const;
+  };
+
+  // Every catalog of the active locale's fallback chain merged when a locale is published, text and
+  // compiled alike, so a lookup is one probe however deep the chain is. Slots are copied from the sources
+  // and the first source with a key wins; strings are still read from the sources in place. Chains with
+  // a lazily loaded catalog aren't merged and are probed file by file (see build).
+  class resolved_table
+  {
+  public:
+    // nullptr if a source can't be merged (lazily loaded catalogs), lookups then probe the sources in turn
+    static std::shared_ptr<const resolved_table> build(std::vector<std::shared_ptr<const dictionary>> sources);
+
+    message find(std::uint64_t hash, std::string_view ns, std::string_view msgid, bool verifyText) const;
+
+    const std::vector<std::shared_ptr<const dictionary>>& sources() const { return m_sources; }
+
+    std::size_t bytes() const { return m_entries.size() * sizeof(entry); }
+
+  private:
+    struct entry
+    {
+      dictionary::slot slot; // Offsets into m_sources[source], hash 0 marks an empty entry
+      std::uint32_t source;
+    };
+
+    std::vector<std::shared_ptr<const dictionary>> m_sources; // Highest priority first
+    std::vector<entry> m_entries; // Capacity is always a power of two
+  };
+
+  // A locale file loaded from the locale directory or one of the overlay directories
+  struct locale_catalog
+  {
+    std::string locale;
+    std::filesystem::path directory;
+    std::shared_ptr<const dictionary> catalog;
+  };
+
+  // Everything a lookup reads. A snapshot is never modified once published, so readers need no lock.
+  struct snapshot
+  {
+    std::string locale;
+    std::string requested; // The locale asked for, locale is the default locale if none of its files exist
+    std::string defaultNS;
+    std::uint64_t defaultNSHash = 0;
+    // Highest priority first: the locale, its parent locales, then the default locale, each preceded by
+    // its overlays. Empty if no locale file exists at all.
+    std::vector<locale_catalog> catalogs;
+    std::size_t defaultCatalogs = 0; // The last ones, which belong to the default locale
+    std::shared_ptr<const resolved_table> resolved; // All catalogs in one table, nullptr if there is only one or one is lazy
+    std::unique_ptr<std::atomic<std::uint64_t>[]> missCache; // Direct-mapped hashes of recent misses, lossy on purpose
+    std::size_t missCacheMask = 0;
+    std::vector<message> messages; // The registered message table resolved in ID order, misses hold the msgid
+  };
+
+  static constexpr std::uint64_t hashString(std::string_view str);
+
+  static constexpr std::uint64_t hashKey(std::uint64_t nsHash, std::uint64_t msgidHash);
 
 public:
 
@@ -28,54 +425,507 @@ public:
   static i18n& GetInstance();
 
   static void SetLocale(const std::string locale);
-  
+
+  // Loads the locale on a background thread and publishes it once it is ready, lookups keep using the
+  // current locale until then. Requests queued before the loader gets to them are collapsed into the
+  // latest one, and a later SetLocale / SetLocaleAsync / Init wins over an earlier request still loading.
+  // The future is ready when the request has been published or superseded.
+  static std::future<void> SetLocaleAsync(std::string locale);
+
+  // Tells the library this thread holds no view from TranslateView, I18N and the like any more, e.g. at
+  // the start of a frame. Once a thread calls Poll, catalogs it read from are kept until its next Poll,
+  // so its views survive a locale change made meanwhile by another thread (SetLocaleAsync). A thread
+  // that polls has to keep doing so until it exits, or replaced locales are never freed.
+  static void Poll();
+
   static std::string GetLocale();
 
+  // Message key hashed at compile time, see operator""_i18n. A key without a namespace uses the default one.
+  class key
+  {
+  public:
+    constexpr key(std::string_view msgid) : m_msgid(msgid), m_msgidHash(hashString(msgid)) {}
+    constexpr key(std::string_view ns, std::string_view msgid) : m_ns(ns), m_msgid(msgid), m_msgidHash(hashString(msgid)), m_hash(hashKey(hashString(ns), m_msgidHash)) {}
+
+    constexpr std::string_view ns() const { return m_ns; }
+    constexpr std::string_view msgid() const { return m_msgid; }
+
+  private:
+    friend class i18n;
+    std::string_view m_ns;
+    std::string_view m_msgid;
+    std::uint64_t m_msgidHash;
+    std::uint64_t m_hash = 0; // Combined (namespace, msgid) hash, 0 if the key has no namespace
+  };
+
+  template<typename... Types>
+  static std::string Translate(std::string_view msgid, const Types&... args);
+
+  template<typename... Types>
+  static std::string Translate(const key& key, const Types&... args);
+
+  template<typename... Types>
+  static std::string TranslateN(std::string_view nameSpace, std::string_view msgid, const Types&... args);
+
+  template<typename... Types>
+  static std::string TranslateN(std::string_view nameSpace, const key& key, const Types&... args);
+
+  // Allocation-free lookups. The returned view points into the loaded dictionary (or at msgid itself
+  // when there is no translation). On a thread that calls Poll it stays valid until that thread's next
+  // Poll, whichever thread changes the locale. Otherwise it is valid until the next Init, SetLocale or
+  // other locale change, so copy it if another thread may change the locale meanwhile (SetLocaleAsync).
+  // Translations are NUL-terminated, so `.data()` can be handed to C APIs as long as msgid is too.
+  static std::string_view TranslateView(std::string_view msgid);
+
+  static std::string_view TranslateView(const key& key);
+
+  static std::string_view TranslateNView(std::string_view nameSpace, std::string_view msgid);
+
+  static std::string_view TranslateNView(std::string_view nameSpace, const key& key);
+
+#ifdef __cpp_lib_span
+  template<typename T>
+  using span = std::span<T>;
+#else
+  // The part of std::span the API uses, for C++17: built from an array or a contiguous container
+  template<typename T>
+  class span
+  {
+  public:
+    constexpr span() = default;
+    constexpr span(T* data, std::size_t size) : m_data(data), m_size(size) {}
+    template<std::size_t N>
+    constexpr span(T (&array)[N]) : m_data(array), m_size(N) {}
+    template<typename Container, typename = decltype(std::data(std::declval<Container&>()))>
+    constexpr span(Container& container) : m_data(std::data(container)), m_size(std::size(container)) {}
+
+    constexpr T* data() const { return m_data; }
+    constexpr std::size_t size() const { return m_size; }
+    constexpr T* begin() const { return m_data; }
+    constexpr T* end() const { return m_data + m_size; }
+
+  private:
+    T* m_data = nullptr;
+    std::size_t m_size = 0;
+  };
+#endif
+
+  // Dense message ID, an index into the message table generated by the message-extractor tool
+  enum class message_id : std::uint32_t {};
+
+  // The table message-extractor generates: keys[id] is the message with that ID. It is resolved against
+  // the fallback chain at every locale change, so a lookup by ID is a bounds-checked array index with no
+  // hashing or string comparison. Only one table is kept, registering again replaces it. keys must stay
+  // valid for the rest of the program. Always returns true, so a static initializer can call it.
+  static bool RegisterMessageTable(span<const key> keys);
+
+  // Lookups by ID behave like their key counterparts. An ID outside the table gives an empty string, in
+  // debug and release builds alike.
+  template<typename... Types>
+  static std::string Translate(message_id id, const Types&... args);
+
+  static std::string_view TranslateView(message_id id);
+
+  template<typename OutputIt, typename... Types>
+  static OutputIt TranslateTo(OutputIt out, message_id id, const Types&... args);
+
+  // What the I18N / I18N_N macros keep at each call site, one per thread: the message a key resolved
+  // to and the generation it was resolved in. The lookup is only repeated after a locale change.
+  class site_cache
+  {
+    friend class i18n;
+    std::uint64_t m_generation = 0;
+    message m_message;
+  };
+
+  // The view stays valid until the locale changes, like TranslateView.
+  // With args the cached message is formatted into a new std::string.
+  template<typename... Types>
+  static auto TranslateCached(site_cache& site, const key& key, const Types&... args);
+
+  // Write the translated and formatted string to an output iterator (e.g. std::back_inserter of a
+  // reused std::string, or fmt::appender of a fmt::memory_buffer) instead of returning a new string.
+  template<typename OutputIt, typename... Types>
+  static OutputIt TranslateTo(OutputIt out, std::string_view msgid, const Types&... args);
+
+  template<typename OutputIt, typename... Types>
+  static OutputIt TranslateTo(OutputIt out, const key& key, const Types&... args);
+
+  template<typename OutputIt, typename... Types>
+  static OutputIt TranslateNTo(OutputIt out, std::string_view nameSpace, std::string_view msgid, const Types&... args);
+
+  template<typename OutputIt, typename... Types>
+  static OutputIt TranslateNTo(OutputIt out, std::string_view nameSpace, const key& key, const Types&... args);
+
+  // Like format_to_n: `out` is one past the last character written and `size` is the length of the
+  // whole result, so the output was truncated if size > buffer.size(). Nothing is NUL-terminated.
+  struct buffer_result
+  {
+    char* out;
+    std::size_t size;
+  };
+
+  // Write into a fixed buffer, truncating if it is too small. Never allocates.
+  template<typename... Types>
+  static buffer_result TranslateToBuffer(span<char> buffer, std::string_view msgid, const Types&... args);
+
   template<typename... Types>
-  static const std::string Translate(std::string msgid, Types... args);
+  static buffer_result TranslateToBuffer(span<char> buffer, const key& key, const Types&... args);
 
   template<typename... Types>
-  static const std::string TranslateN(std::string nameSpace, std::string msgid, Types... args);
+  static buffer_result TranslateNToBuffer(span<char> buffer, std::string_view nameSpace, std::string_view msgid, const Types&... args);
+
+  template<typename... Types>
+  static buffer_result TranslateNToBuffer(span<char> buffer, std::string_view nameSpace, const key& key, const Types&... args);
+
+  // Remember up to `entries` (rounded up to a power of two) keys that have no translation, so looking
+  // them up again skips the dictionaries. 0 disables the cache. It is dropped on every SetLocale.
+  static void SetMissCacheSize(std::size_t entries);
+
+  // Number of lookups that found no translation in any loaded dictionary and returned msgid.
+  static std::uint64_t GetMissCount();
+
+  // Parse text locale files of several MB on up to `threads` threads (0 = one per hardware thread).
+  // The default of 1 parses on the calling thread. Compiled catalogs are not affected.
+  static void SetParseThreads(std::size_t threads);
+
+  // Keep up to `locales` recently used locales loaded (and under `bytes` of catalog data if not 0), so
+  // switching back to one doesn't load it again. The least recently used one is dropped first. 0 disables
+  // the cache, which is the default. Init empties it.
+  static void SetLocaleCacheSize(std::size_t locales, std::size_t bytes = 0);
+
+  struct locale_cache_stats
+  {
+    std::uint64_t hits;
+    std::uint64_t misses; // Locales that had to be loaded
+    std::uint64_t evictions;
+    std::size_t locales; // Currently resident
+    std::size_t bytes;
+  };
+
+  static locale_cache_stats GetLocaleCacheStats();
+
+  // Watch the locale directory and reload the files of the active locale, its parents and the default
+  // locale when they are written (text or compiled), deleted or created again. A reloaded file is only
+  // published if its entries actually changed, and the other files are shared as they are. Overlay
+  // directories aren't watched. While watching, files in the locale directory are read into memory
+  // instead of mapped, so rewriting one in place is safe. Returns false if file watching isn't
+  // supported (Linux only).
+  static bool SetHotReload(bool enabled);
+
+  // Load text locale files lazily: an index of where each namespace's entries are is built when the
+  // locale is loaded, and a namespace is only parsed the first time it is looked up. With indexFile the
+  // index is also kept in "<locale><extension>i" so it doesn't have to be rebuilt. The file stays mapped
+  // while the locale is loaded, so replace it (write a new file and rename it) rather than editing it in
+  // place, unless hot reload is on (see SetHotReload). Applies to locales loaded afterwards; compiled
+  // catalogs are unaffected.
+  static void SetLazyNamespaces(bool enabled, bool indexFile = false);
+
+  // Allocate catalogs from resource (nullptr for the default resource). Each loaded locale file gets a
+  // monotonic arena on top of it, so its entries take a few large blocks that are released together when
+  // the locale is unloaded. The loaded locales are reloaded from resource and the locale cache is cleared,
+  // so once this returns nothing uses the previous resource any more and it can be destroyed. It waits
+  // for the threads that call Poll to poll, and ends the views of the calling thread.
+  static void SetMemoryResource(std::pmr::memory_resource* resource);
+
+  // Store each distinct msgid and msgstr text once per locale file, e.g. "Back" in several namespaces, or
+  // a msgstr equal to its msgid as in the default locale. Namespace names are always stored once. Costs
+  // parse time, so it is off by default; applies to locales loaded or compiled afterwards. Sharing text
+  // between locale files, e.g. the msgids both the default and the active locale store, is out of scope:
+  // a catalog's slots are offsets into its own string blob, which is what lets a compiled catalog be
+  // mapped as it is and a locale be freed as one arena. Compile the locales to keep that text in shared,
+  // read-only file pages instead of the heap.
+  static void SetStringInterning(bool enabled);
+
+  struct memory_stats
+  {
+    std::size_t catalogs; // Distinct locale files loaded: the current chain and cached locales
+    std::size_t entries; // A lazily loaded catalog counts the namespaces looked up so far
+    std::size_t indexedEntries; // All entries of the lazily loaded catalogs, looked up or not, as their index counts them
+    std::size_t bytes; // Slots, format segments and strings of those catalogs
+    std::size_t mappedBytes; // Part of bytes read from compiled catalogs' mappings or embedded images, shared between processes
+    std::size_t internedBytes; // String bytes not stored because an identical string was stored already in the same file
+    std::size_t resolvedBytes; // The merged fallback tables, the current one and those kept with cached locales
+  };
+
+  static memory_stats GetMemoryStats();
+
+  // Directories searched for locale files before the locale path, the last one first. A translation in
+  // an overlay (e.g. a mod's "mods/foo/zh-CN.locale") replaces the one in the locale path, other keys
+  // are still found there. Reloads the default and current locale right away and empties the locale cache;
+  // called before Init, it only stores the paths for Init to use.
+  static void SetOverlayPaths(std::vector<std::filesystem::path> paths);
+
+  // Convert a text locale file to the compiled format. Init / SetLocale load "<locale><extension>c"
+  // (e.g. zh-CN.localec) instead of the text file when it is present and not older than it.
+  static bool CompileLocale(const std::filesystem::path& source, const std::filesystem::path& destination, std::string_view defaultNS = "default");
+
+  // Use a compiled catalog linked into the program instead of the locale's files in the locale path, so
+  // loading it reads no file and its pages are shared read-only. Headers generated by the i18n.embed
+  // xmake rule (locale-compiler --embed) call this from a static initializer; image must stay valid
+  // for the rest of the program. Applies to locales loaded afterwards. An image built with another
+  // default namespace is ignored and the files are read instead. Always returns true.
+  static bool RegisterEmbeddedCatalog(std::string_view locale, std::string_view image);
 
 private:
-  i18n() {}
-  ~i18n() {}
+  // Output iterator behind TranslateToBuffer: stores until the buffer is full and counts everything.
+  // The position lives in the caller's buffer_result, so copies of the iterator all write through it.
+  class truncating_iterator
+  {
+  public:
+    using iterator_category = std::output_iterator_tag;
+    using value_type = void;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = void;
 
+    truncating_iterator() = default;
+    truncating_iterator(buffer_result& result, char* end) : m_result(&result), m_end(end) {}
+
+    const truncating_iterator& operator=(char c) const
+    {
+      if (m_result->out != m_end) *m_result->out++ = c;
+      ++m_result->size;
+      return *this;
+    }
+    const truncating_iterator& operator*() const { return *this; }
+    truncating_iterator& operator++() { return *this; }
+    truncating_iterator operator++(int) { return *this; }
+
+  private:
+    buffer_result* m_result = nullptr;
+    char* m_end = nullptr;
+  };
+
+  i18n() : m_snapshot(std::make_shared<const snapshot>()), m_current(m_snapshot.get()) {}
+  ~i18n();
+
+  // Only touched by Init / SetLocale, under m_mutex
+  std::mutex m_mutex;
   std::filesystem::path m_localePath;
   std::string m_localeExtension;
-  bool m_defaultLocale_exists;
   std::string m_defaultLocale;
-  std::string m_locale;
-  dictionary m_defaultDictionary;
-  dictionary m_dictionary;
   std::string m_defaultNS;
+  std::vector<std::filesystem::path> m_overlayPaths;
+  span<const key> m_messageTable;
+  std::unordered_map<std::string, std::string_view> m_embeddedCatalogs; // Locale to compiled catalog image
+  std::vector<locale_catalog> m_defaultCatalogs;
+  std::size_t m_missCacheSize = 0;
+  std::size_t m_parseThreads = 1;
+  std::pmr::memory_resource* m_memoryResource = nullptr;
+  bool m_internStrings = false;
+  bool m_lazyNamespaces = false;
+  bool m_lazyIndexFile = false;
+  bool m_copyFiles = false; // While the watcher runs, files in the locale path are read instead of mapped
+
+  struct cached_locale
+  {
+    std::string locale;
+    std::vector<locale_catalog> catalogs; // The locale's file and its overlays
+    std::size_t bytes; // When it was cached, lazily loaded catalogs grow as they are used
+    std::shared_ptr<const resolved_table> resolved = nullptr; // Last built for a chain starting with this locale, counted in bytes
+  };
+  std::vector<cached_locale> m_localeCache; // Most recently used first
+  std::size_t m_localeCacheLocales = 0;
+  std::size_t m_localeCacheBytes = 0;
+  locale_cache_stats m_localeCacheStats {};
+
+  // Each thread that translates, so publish can tell which replaced snapshots may still be read
+  struct reader
+  {
+    explicit reader(i18n& instance);
+    ~reader();
+    i18n& instance;
+    // m_generation when the outermost lookup started, 0 between lookups. Once the thread polls, it is set
+    // by the first lookup after a Poll and only cleared by the next one, so its views stay valid until then.
+    std::atomic<std::uint64_t> epoch {0};
+    unsigned depth = 0; // Lookups nest when a formatter translates
+    bool polling = false;
+  };
+  std::mutex m_readersMutex;
+  std::vector<const reader*> m_readers;
+
+  // What acquire() returns. The snapshot isn't freed before this thread's outermost guard is gone.
+  class snapshot_guard
+  {
+  public:
+    snapshot_guard(reader& reader, const snapshot& snapshot) : m_reader(reader), m_snapshot(snapshot) {}
+    snapshot_guard(const snapshot_guard&) = delete;
+    snapshot_guard& operator=(const snapshot_guard&) = delete;
+    ~snapshot_guard() { if (--m_reader.depth == 0 && !m_reader.polling) m_reader.epoch.store(0, std::memory_order_release); }
+    operator const snapshot&() const { return m_snapshot; }
+    const snapshot* operator->() const { return &m_snapshot; }
+
+  private:
+    reader& m_reader;
+    const snapshot& m_snapshot;
+  };
+
+  // Snapshots replaced at a generation, freed once every reader started after it
+  struct retired_snapshot
+  {
+    std::uint64_t generation;
+    std::shared_ptr<const snapshot> replaced;
+  };
+
+  // m_snapshot and m_retired are only touched under m_mutex, lookups read m_current
+  std::shared_ptr<const snapshot> m_snapshot;
+  std::vector<retired_snapshot> m_retired;
+  std::atomic<const snapshot*> m_current;
+  std::atomic<std::uint64_t> m_generation {1}; // Bumped after every publish
+  std::atomic<std::uint64_t> m_misses {0};
+
+  // Numbers every Init / SetLocale / SetLocaleAsync, only the latest request gets published
+  std::atomic<std::uint64_t> m_localeRequest {0};
+
+  // SetLocaleAsync queue, the loader thread is started by the first request
+  std::mutex m_asyncMutex;
+  std::condition_variable m_asyncCondition;
+  std::thread m_asyncThread;
+  bool m_asyncStop = false;
+  bool m_asyncPending = false;
+  std::string m_asyncLocale;
+  std::uint64_t m_asyncRequest = 0;
+  std::vector<std::promise<void>> m_asyncWaiting;
+
+  // Hot reload watcher thread
+  std::thread m_reloadThread;
+  std::atomic<bool> m_reloadStop {false};
 
   void ISetLocale(const std::string locale);
 
-  template<typename... Types>
-  std::string ITranslate(std::string msgid, Types... args);
+  void asyncLoop();
+
+  void reloadLoop();
+
+  void reloadFiles(const std::vector<std::string>& files);
+
+  reader& threadReader();
+
+  snapshot_guard acquire();
+
+  // chain is the locale's catalogs without the default locale's, which are added from m_defaultCatalogs
+  void publish(std::string locale, std::vector<locale_catalog> chain);
+
+  void republish(); // Same locale and catalogs, with the current settings
+
+  void reclaim(); // Frees the retired snapshots no lookup can still be reading
 
   template<typename... Types>
-  std::string ITranslateN(std::string ns, std::string msgid, Types... args);
+  std::string IFormat(const message& message, const Types&... args);
+
+  template<typename OutputIt, typename... Types>
+  OutputIt IFormatTo(OutputIt out, const message& message, const Types&... args);
+
+  template<typename OutputIt, typename Type, typename FormatArgs>
+  static OutputIt formatField(OutputIt out, const format_segment& segment, const char* strings, const Type& value, const FormatArgs& formatArgs);
+
+  message ILookup(const snapshot& snapshot, std::string_view ns, std::string_view msgid);
+
+  message ILookup(const snapshot& snapshot, const key& key);
+
+  message ILookup(const snapshot& snapshot, std::string_view ns, const key& key);
+
+  message IResolve(const snapshot& snapshot, std::uint64_t hash, std::string_view ns, std::string_view msgid, bool verifyText);
+
+  static message IFind(const snapshot& snapshot, std::uint64_t hash, std::string_view ns, std::string_view msgid, bool verifyText); // msgstr.data() is nullptr on a miss
+
+  static const message& IMessage(const snapshot& snapshot, message_id id);
+
+  const message& ICached(site_cache& site, const key& key);
+
+  static dictionary parseDictionary(std::filesystem::path locale_path, std::string_view defaultNS, std::size_t threads = 1, std::shared_ptr<std::pmr::memory_resource> arena = nullptr, bool internText = false);
+
+  static void parseBuffer(std::string_view text, std::string_view defaultNS, dictionary& dictionary);
+
+  // Runs the locale file state machine over text, calling onEntry(nsHash, ns, msgid, msgstr, begin, end)
+  // for every msgstr line. [begin, end) is the entry's record: parsed on its own it gives the same entry.
+  template<typename OnEntry>
+  static void scanEntries(std::string_view text, std::string_view defaultNS, OnEntry&& onEntry);
+
+  static constexpr std::size_t parseChunkMinSize = std::size_t(4) << 20; // Smaller chunks aren't worth a thread
 
-  dictionary parseDictionary(std::filesystem::path locale_path);
+  static dictionary parseParallel(std::string_view text, std::string_view defaultNS, std::size_t threads, std::shared_ptr<std::pmr::memory_resource> arena, bool internText);
 
   void loadDefaultDictionary();
 
-  void loadDictionary(const std::string locale);
+  // Catalogs of the locale and its parent locales (not the default locale), see getLocaleChain
+  std::vector<locale_catalog> loadDictionary(const std::string locale);
 
-  std::filesystem::path getLocalePath(std::string locale);
+  std::vector<locale_catalog> loadCatalogs(const std::string& locale); // One locale and its overlays, through the cache
+
+  std::vector<locale_catalog> readCatalogs(const std::string& locale);
+
+  void trimLocaleCache();
+
+  std::shared_ptr<const dictionary> readDictionary(const std::filesystem::path& directory, const std::string& locale);
+
+  std::shared_ptr<std::pmr::memory_resource> makeArena(); // For one locale file, on top of m_memoryResource
+
+  // zh-Hant-TW -> zh-Hant, zh: drop subtags from the end, and a single letter extension or private use
+  // prefix ("x" in en-x-pirate) with the subtag after it (RFC 4647 lookup). '_' works like '-'.
+  static std::vector<std::string> getLocaleChain(std::string_view locale);
+
+  std::filesystem::path getLocalePath(std::string locale, const std::filesystem::path& directory);
+
+  std::filesystem::path getCompiledLocalePath(std::string locale, const std::filesystem::path& directory);
+
+  std::filesystem::path getIndexLocalePath(std::string locale, const std::filesystem::path& directory); // Namespace index for lazy loading
 };
 
+constexpr std::uint64_t i18n::hashString(std::string_view str)
+{
+  std::uint64_t hash = 0xcbf29ce484222325ull; // FNV-1a, stable across platforms and usable at compile time
+  for (char c : str)
+  {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 0x100000001b3ull;
+  }
+  return hash;
+}
+
+constexpr std::uint64_t i18n::hashKey(std::uint64_t nsHash, std::uint64_t msgidHash)
+{
+  std::uint64_t hash = msgidHash ^ (nsHash + 0x9e3779b97f4a7c15ull + (msgidHash << 6) + (msgidHash >> 2));
+  hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ull; // splitmix64 finalizer, so the low bits can index the table
+  hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebull;
+  hash ^= hash >> 31;
+  return hash ? hash : 1; // 0 is reserved for empty slots
+}
+
+// "Hello, world!"_i18n hashes the msgid at compile time, see i18n::key.
+i18n_consteval i18n::key operator""_i18n(const char* msgid, std::size_t length)
+{
+  return i18n::key(std::string_view(msgid, length));
+}
+
+// Translate with a lookup cached at the call site: after the first call on a thread, a call costs one
+// atomic load and a compare until the locale changes. The key is hashed at compile time, so msgid (and
+// ns) must be literals. I18N("Back") gives a std::string_view, I18N("counter = {:d}", counter) a std::string.
+// ", ##__VA_ARGS__" instead of __VA_OPT__ keeps them working with MSVC's traditional preprocessor.
+#define I18N(msgid, ...) ([&]() -> decltype(auto) { \
+    static constexpr i18n::key i18n_site_key {msgid}; \
+    thread_local i18n::site_cache i18n_site; \
+    return i18n::TranslateCached(i18n_site, i18n_site_key, ##__VA_ARGS__); }())
+
+#define I18N_N(ns, msgid, ...) ([&]() -> decltype(auto) { \
+    static constexpr i18n::key i18n_site_key {ns, msgid}; \
+    thread_local i18n::site_cache i18n_site; \
+    return i18n::TranslateCached(i18n_site, i18n_site_key, ##__VA_ARGS__); }())
+
 inline void i18n::Init(std::filesystem::path localePath, std::string locale, std::string defaultLocale, std::string defaultNS, std::string localeExtension)
 {
-  GetInstance().m_localePath = localePath;
-  GetInstance().m_defaultLocale = defaultLocale;
-  GetInstance().m_locale = locale;
-  GetInstance().m_defaultNS = defaultNS;
-  GetInstance().m_localeExtension = localeExtension;
-  GetInstance().loadDefaultDictionary();
-  SetLocale(locale);
+  i18n& instance = GetInstance();
+  std::lock_guard<std::mutex> lock(instance.m_mutex);
+  ++instance.m_localeRequest;
+  instance.m_localePath = localePath;
+  instance.m_defaultLocale = defaultLocale;
+  instance.m_defaultNS = defaultNS;
+  instance.m_localeExtension = localeExtension;
+  instance.m_localeCache.clear();
+  instance.m_localeCacheStats.locales = instance.m_localeCacheStats.bytes = 0;
+  instance.loadDefaultDictionary();
+  instance.publish(locale, instance.loadDictionary(locale));
 }
 
 inline i18n& i18n::GetInstance()
@@ -90,167 +940,1955 @@ inline void i18n::SetLocale(const std::string locale)
 }
 
 inline std::string i18n::GetLocale() {
-  return GetInstance().m_locale;
+  return GetInstance().acquire()->locale;
 }
 
 template<typename... Types>
-inline const std::string i18n::Translate(std::string msgid, Types... args) {
-  return GetInstance().ITranslate(msgid, std::forward<Types>(args)...);
+inline std::string i18n::Translate(std::string_view msgid, const Types&... args) {
+  i18n& instance = GetInstance();
+  const snapshot_guard snapshot = instance.acquire();
+  return instance.IFormat(instance.ILookup(snapshot, snapshot->defaultNS, msgid), args...);
 }
 
 template<typename... Types>
-inline const std::string i18n::TranslateN(std::string nameSpace, std::string msgid, Types... args) {
-  return GetInstance().ITranslateN(nameSpace, msgid, std::forward<Types>(args)...);
+inline std::string i18n::Translate(const key& key, const Types&... args) {
+  i18n& instance = GetInstance();
+  return instance.IFormat(instance.ILookup(instance.acquire(), key), args...);
 }
 
-inline void i18n::ISetLocale(const std::string locale)
-{
-  m_locale = locale;
-  loadDictionary(locale);
+template<typename... Types>
+inline std::string i18n::TranslateN(std::string_view nameSpace, std::string_view msgid, const Types&... args) {
+  i18n& instance = GetInstance();
+  return instance.IFormat(instance.ILookup(instance.acquire(), nameSpace, msgid), args...);
 }
 
 template<typename... Types>
-inline std::string i18n::ITranslate(std::string msgid, Types... args)
+inline std::string i18n::TranslateN(std::string_view nameSpace, const key& key, const Types&... args) {
+  i18n& instance = GetInstance();
+  return instance.IFormat(instance.ILookup(instance.acquire(), nameSpace, key), args...);
+}
+
+inline std::string_view i18n::TranslateView(std::string_view msgid) {
+  i18n& instance = GetInstance();
+  const snapshot_guard snapshot = instance.acquire();
+  return instance.ILookup(snapshot, snapshot->defaultNS, msgid).msgstr;
+}
+
+inline std::string_view i18n::TranslateView(const key& key) {
+  i18n& instance = GetInstance();
+  return instance.ILookup(instance.acquire(), key).msgstr;
+}
+
+inline std::string_view i18n::TranslateNView(std::string_view nameSpace, std::string_view msgid) {
+  i18n& instance = GetInstance();
+  return instance.ILookup(instance.acquire(), nameSpace, msgid).msgstr;
+}
+
+inline std::string_view i18n::TranslateNView(std::string_view nameSpace, const key& key) {
+  i18n& instance = GetInstance();
+  return instance.ILookup(instance.acquire(), nameSpace, key).msgstr;
+}
+
+inline bool i18n::RegisterMessageTable(span<const key> keys)
 {
-  switch (sizeof...(Types) == 0)
-  {
-  case true:
-    if (!m_defaultLocale_exists) // If not using a locale file for the default locale
-    {
-      if (m_locale == m_defaultLocale) return msgid; // Current locale is the default locale
-      if (!m_dictionary[m_defaultNS].count(msgid)) return msgid; // Tranlation doesn't exist in the locale file
-      return m_dictionary[m_defaultNS][msgid]; // Return translated string from the dictionary
-    }
-    // If using a locale file for the default locale
-    if (m_locale == m_defaultLocale) return m_defaultDictionary[m_defaultNS][msgid]; // Current locale is the default locale
-    if (!m_dictionary[m_defaultNS].count(msgid)) return m_defaultDictionary[m_defaultNS][msgid]; // Tranlation doesn't exist in the locale file
-    return m_dictionary[m_defaultNS][msgid]; // Return translated string from the dictionary
-    break;
-  
-  case false:
-    if (!m_defaultLocale_exists) // If not using a locale file for the default locale
-    {
-      if (m_locale == m_defaultLocale) return i18n_format(msgid, std::forward<Types>(args)...); // Current locale is the default locale
-      if (!m_dictionary[m_defaultNS].count(msgid)) return i18n_format(msgid, std::forward<Types>(args)...); // Tranlation doesn't exist in the locale file
-      return i18n_format(m_dictionary[m_defaultNS][msgid], std::forward<Types>(args)...); // Return translated string from the dictionary
-    }
-    // If using a locale file for the default locale
-    if (m_locale == m_defaultLocale) return i18n_format(m_defaultDictionary[m_defaultNS][msgid], std::forward<Types>(args)...); // Current locale is the default locale
-    if (!m_dictionary[m_defaultNS].count(msgid)) return i18n_format(m_defaultDictionary[m_defaultNS][msgid], std::forward<Types>(args)...); // Tranlation doesn't exist in the locale file
-    return i18n_format(m_dictionary[m_defaultNS][msgid], std::forward<Types>(args)...); // Return translated string from the dictionary
-    break;
-  }
+  i18n& instance = GetInstance();
+  std::lock_guard<std::mutex> lock(instance.m_mutex);
+  instance.m_messageTable = keys;
+  instance.republish();
+  return true;
 }
 
 template<typename... Types>
-inline std::string i18n::ITranslateN(std::string ns, std::string msgid, Types... args)
-{
-  switch (sizeof...(Types) == 0)
-  {
-  case true:
-    if (!m_defaultLocale_exists) // If not using a locale file for the default locale
-    {
-      if (m_locale == m_defaultLocale) return msgid; // Current locale is the default locale
-      if (!m_dictionary[ns].count(msgid)) return msgid; // Tranlation doesn't exist in the locale file
-      return m_dictionary[ns][msgid]; // Return translated string from the dictionary
-    }
-    // If using a locale file for the default locale
-    if (m_locale == m_defaultLocale) return m_defaultDictionary[ns][msgid]; // Current locale is the default locale
-    if (!m_dictionary[ns].count(msgid)) return m_defaultDictionary[ns][msgid]; // Tranlation doesn't exist in the locale file
-    return m_dictionary[ns][msgid]; // Return translated string from the dictionary
-    break;
-
-  case false:
-    if (!m_defaultLocale_exists) // If not using a locale file for the default locale
-    {
-      if (m_locale == m_defaultLocale) return i18n_format(msgid, std::forward<Types>(args)...); // Current locale is the default locale
-      if (!m_dictionary[ns].count(msgid)) return i18n_format(msgid, std::forward<Types>(args)...); // Tranlation doesn't exist in the locale file
-      return i18n_format(m_dictionary[ns][msgid], std::forward<Types>(args)...); // Return translated string from the dictionary
-    }
-    // If using a locale file for the default locale
-    if (m_locale == m_defaultLocale) return i18n_format(m_defaultDictionary[ns][msgid], std::forward<Types>(args)...); // Current locale is the default locale
-    if (!m_dictionary[ns].count(msgid)) return i18n_format(m_defaultDictionary[ns][msgid], std::forward<Types>(args)...); // Tranlation doesn't exist in the locale file
-    return i18n_format(m_dictionary[ns][msgid], std::forward<Types>(args)...); // Return translated string from the dictionary
-    break;
-  }
+inline std::string i18n::Translate(message_id id, const Types&... args) {
+  i18n& instance = GetInstance();
+  return instance.IFormat(IMessage(instance.acquire(), id), args...);
 }
 
-inline i18n::dictionary i18n::parseDictionary(std::filesystem::path locale_path)
-{
-  dictionary dictionary;
-  enum lineType { NS, MSG_ID, MSG_STR };
-  std::string line;
-  std::string ns_cache, msgid_cache;
-  lineType prev_type;
-  std::ifstream file (locale_path);
+inline std::string_view i18n::TranslateView(message_id id) {
+  return IMessage(GetInstance().acquire(), id).msgstr;
+}
 
-  while (std::getline(file, line))
+template<typename OutputIt, typename... Types>
+inline OutputIt i18n::TranslateTo(OutputIt out, message_id id, const Types&... args) {
+  i18n& instance = GetInstance();
+  return instance.IFormatTo(out, IMessage(instance.acquire(), id), args...);
+}
+
+template<typename OutputIt, typename... Types>
+inline OutputIt i18n::TranslateTo(OutputIt out, std::string_view msgid, const Types&... args) {
+  i18n& instance = GetInstance();
+  const snapshot_guard snapshot = instance.acquire();
+  return instance.IFormatTo(out, instance.ILookup(snapshot, snapshot->defaultNS, msgid), args...);
+}
+
+template<typename OutputIt, typename... Types>
+inline OutputIt i18n::TranslateTo(OutputIt out, const key& key, const Types&... args) {
+  i18n& instance = GetInstance();
+  return instance.IFormatTo(out, instance.ILookup(instance.acquire(), key), args...);
+}
+
+template<typename OutputIt, typename... Types>
+inline OutputIt i18n::TranslateNTo(OutputIt out, std::string_view nameSpace, std::string_view msgid, const Types&... args) {
+  i18n& instance = GetInstance();
+  return instance.IFormatTo(out, instance.ILookup(instance.acquire(), nameSpace, msgid), args...);
+}
+
+template<typename OutputIt, typename... Types>
+inline OutputIt i18n::TranslateNTo(OutputIt out, std::string_view nameSpace, const key& key, const Types&... args) {
+  i18n& instance = GetInstance();
+  return instance.IFormatTo(out, instance.ILookup(instance.acquire(), nameSpace, key), args...);
+}
+
+template<typename... Types>
+inline i18n::buffer_result i18n::TranslateToBuffer(span<char> buffer, std::string_view msgid, const Types&... args) {
+  buffer_result result {buffer.data(), 0};
+  TranslateTo(truncating_iterator(result, buffer.data() + buffer.size()), msgid, args...);
+  return result;
+}
+
+template<typename... Types>
+inline i18n::buffer_result i18n::TranslateToBuffer(span<char> buffer, const key& key, const Types&... args) {
+  buffer_result result {buffer.data(), 0};
+  TranslateTo(truncating_iterator(result, buffer.data() + buffer.size()), key, args...);
+  return result;
+}
+
+template<typename... Types>
+inline i18n::buffer_result i18n::TranslateNToBuffer(span<char> buffer, std::string_view nameSpace, std::string_view msgid, const Types&... args) {
+  buffer_result result {buffer.data(), 0};
+  TranslateNTo(truncating_iterator(result, buffer.data() + buffer.size()), nameSpace, msgid, args...);
+  return result;
+}
+
+template<typename... Types>
+inline i18n::buffer_result i18n::TranslateNToBuffer(span<char> buffer, std::string_view nameSpace, const key& key, const Types&... args) {
+  buffer_result result {buffer.data(), 0};
+  TranslateNTo(truncating_iterator(result, buffer.data() + buffer.size()), nameSpace, key, args...);
+  return result;
+}
+
+inline void i18n::SetMissCacheSize(std::size_t entries)
+{
+  i18n& instance = GetInstance();
+  std::lock_guard<std::mutex> lock(instance.m_mutex);
+  std::size_t size = 0;
+  if (entries) for (size = 1; size < entries; size <<= 1) {}
+  instance.m_missCacheSize = size;
+  instance.republish(); // So the new size applies right away
+}
+
+inline std::uint64_t i18n::GetMissCount()
+{
+  return GetInstance().m_misses.load(std::memory_order_relaxed);
+}
+
+inline void i18n::SetLocaleCacheSize(std::size_t locales, std::size_t bytes)
+{
+  i18n& instance = GetInstance();
+  std::lock_guard<std::mutex> lock(instance.m_mutex);
+  instance.m_localeCacheLocales = locales;
+  instance.m_localeCacheBytes = bytes;
+  instance.trimLocaleCache();
+}
+
+inline i18n::locale_cache_stats i18n::GetLocaleCacheStats()
+{
+  i18n& instance = GetInstance();
+  std::lock_guard<std::mutex> lock(instance.m_mutex);
+  return instance.m_localeCacheStats;
+}
+
+inline void i18n::SetLazyNamespaces(bool enabled, bool indexFile)
+{
+  i18n& instance = GetInstance();
+  std::lock_guard<std::mutex> lock(instance.m_mutex);
+  instance.m_lazyNamespaces = enabled;
+  instance.m_lazyIndexFile = indexFile;
+}
+
+inline void i18n::SetOverlayPaths(std::vector<std::filesystem::path> paths)
+{
+  // Not a locale request: a pending SetLocaleAsync loads under m_mutex too, so it picks up the new
+  // overlays either way and still publishes its locale afterwards
+  i18n& instance = GetInstance();
+  std::lock_guard<std::mutex> lock(instance.m_mutex);
+  instance.m_overlayPaths = std::move(paths);
+  if (instance.m_defaultLocale.empty()) return; // Before Init there's no locale to reload, Init loads the overlays
+  instance.m_localeCache.clear();
+  instance.m_localeCacheStats.locales = instance.m_localeCacheStats.bytes = 0;
+  instance.loadDefaultDictionary();
+  const std::string locale = instance.m_snapshot->requested;
+  instance.publish(locale, instance.loadDictionary(locale));
+}
+
+inline void i18n::SetMemoryResource(std::pmr::memory_resource* resource)
+{
+  i18n& instance = GetInstance();
+  std::lock_guard<std::mutex> lock(instance.m_mutex);
+  instance.m_memoryResource = resource;
+  instance.m_localeCache.clear();
+  instance.m_localeCacheStats.locales = instance.m_localeCacheStats.bytes = 0;
+  if (!instance.m_defaultLocale.empty()) // Init was called, reload what it loaded
+  {
+    instance.loadDefaultDictionary();
+    const std::string locale = instance.m_snapshot->requested;
+    instance.publish(locale, instance.loadDictionary(locale));
+  }
+  // Wait for the lookups still reading the previous catalogs, and for polling threads to poll. This
+  // thread's views are dropped, or it would wait for itself.
+  if (reader& reader = instance.threadReader(); !reader.depth) reader.epoch.store(0, std::memory_order_release);
+  for (instance.reclaim(); !instance.m_retired.empty(); instance.reclaim()) std::this_thread::yield();
+}
+
+inline void i18n::SetStringInterning(bool enabled)
+{
+  i18n& instance = GetInstance();
+  std::lock_guard<std::mutex> lock(instance.m_mutex);
+  instance.m_internStrings = enabled;
+}
+
+inline bool i18n::RegisterEmbeddedCatalog(std::string_view locale, std::string_view image)
+{
+  i18n& instance = GetInstance();
+  std::lock_guard<std::mutex> lock(instance.m_mutex);
+  instance.m_embeddedCatalogs[std::string(locale)] = image;
+  return true;
+}
+
+inline i18n::memory_stats i18n::GetMemoryStats()
+{
+  i18n& instance = GetInstance();
+  std::lock_guard<std::mutex> lock(instance.m_mutex);
+  const std::shared_ptr<const snapshot> current = instance.m_snapshot;
+  std::vector<const dictionary*> counted;
+  memory_stats stats {};
+  auto add = [&](const locale_catalog& loaded) {
+    if (std::find(counted.begin(), counted.end(), loaded.catalog.get()) != counted.end()) return;
+    counted.push_back(loaded.catalog.get());
+    const std::size_t bytes = loaded.catalog->bytes();
+    ++stats.catalogs;
+    stats.entries += loaded.catalog->size();
+    stats.indexedEntries += loaded.catalog->indexedSize();
+    stats.bytes += bytes;
+    if (loaded.catalog->mapped()) stats.mappedBytes += bytes;
+    stats.internedBytes += loaded.catalog->internedBytes();
+  };
+  for (const locale_catalog& loaded : current->catalogs) add(loaded);
+  for (const cached_locale& cached : instance.m_localeCache)
+    for (const locale_catalog& loaded : cached.catalogs) add(loaded);
+  if (current->resolved) stats.resolvedBytes = current->resolved->bytes();
+  for (const cached_locale& cached : instance.m_localeCache)
+    if (cached.resolved && cached.resolved != current->resolved) stats.resolvedBytes += cached.resolved->bytes();
+  return stats;
+}
+
+inline void i18n::SetParseThreads(std::size_t threads)
+{
+  i18n& instance = GetInstance();
+  std::lock_guard<std::mutex> lock(instance.m_mutex);
+  instance.m_parseThreads = threads ? threads : std::max(1u, std::thread::hardware_concurrency());
+}
+
+inline bool i18n::CompileLocale(const std::filesystem::path& source, const std::filesystem::path& destination, std::string_view defaultNS)
+{
+  if (!std::filesystem::exists(source)) return false;
+  i18n& instance = GetInstance();
+  std::size_t threads;
+  bool internStrings;
+  {
+    std::lock_guard<std::mutex> lock(instance.m_mutex);
+    threads = instance.m_parseThreads;
+    internStrings = instance.m_internStrings;
+  }
+  return parseDictionary(source, defaultNS, threads, nullptr, internStrings).save(destination, defaultNS);
+}
+
+inline void i18n::ISetLocale(const std::string locale)
+{
+  const std::uint64_t request = ++m_localeRequest;
+  std::lock_guard<std::mutex> lock(m_mutex);
+  std::vector<locale_catalog> chain = loadDictionary(locale);
+  if (request == m_localeRequest) publish(locale, std::move(chain));
+}
+
+inline std::future<void> i18n::SetLocaleAsync(std::string locale)
+{
+  i18n& instance = GetInstance();
+  std::promise<void> promise;
+  std::future<void> future = promise.get_future();
+  {
+    std::lock_guard<std::mutex> lock(instance.m_asyncMutex);
+    instance.m_asyncLocale = std::move(locale);
+    instance.m_asyncRequest = ++instance.m_localeRequest;
+    instance.m_asyncPending = true;
+    instance.m_asyncWaiting.push_back(std::move(promise));
+    if (!instance.m_asyncThread.joinable()) instance.m_asyncThread = std::thread(&i18n::asyncLoop, &instance);
+  }
+  instance.m_asyncCondition.notify_one();
+  return future;
+}
+
+inline void i18n::asyncLoop()
+{
+  std::unique_lock<std::mutex> lock(m_asyncMutex);
+  while (true)
+  {
+    m_asyncCondition.wait(lock, [this] { return m_asyncStop || m_asyncPending; });
+    if (m_asyncStop) return;
+    const std::string locale = std::move(m_asyncLocale);
+    const std::uint64_t request = m_asyncRequest;
+    std::vector<std::promise<void>> waiting = std::move(m_asyncWaiting);
+    m_asyncWaiting.clear();
+    m_asyncPending = false;
+    lock.unlock();
+
+    std::exception_ptr error;
+    try
+    {
+      std::lock_guard<std::mutex> writer(m_mutex);
+      std::vector<locale_catalog> chain = loadDictionary(locale);
+      if (request == m_localeRequest) publish(locale, std::move(chain));
+    }
+    catch (...) { error = std::current_exception(); }
+    for (std::promise<void>& promise : waiting)
+      error ? promise.set_exception(error) : promise.set_value();
+    lock.lock();
+  }
+}
+
+inline i18n::~i18n()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_asyncMutex);
+    m_asyncStop = true;
+  }
+  m_asyncCondition.notify_one();
+  if (m_asyncThread.joinable()) m_asyncThread.join();
+  m_reloadStop = true;
+  if (m_reloadThread.joinable()) m_reloadThread.join();
+}
+
+inline bool i18n::SetHotReload(bool enabled)
+{
+#ifdef __linux__
+  i18n& instance = GetInstance();
+  static std::mutex s_toggle; // Serializes starting and stopping the watcher
+  std::lock_guard<std::mutex> lock(s_toggle);
+  if (instance.m_reloadThread.joinable())
+  {
+    instance.m_reloadStop = true;
+    instance.m_reloadThread.join();
+  }
+  instance.m_reloadStop = false;
+  {
+    // Watched files are copied rather than mapped from now on, and those mapped already are read again
+    std::lock_guard<std::mutex> writer(instance.m_mutex);
+    const bool remap = enabled && !instance.m_copyFiles && !instance.m_defaultLocale.empty();
+    instance.m_copyFiles = enabled;
+    if (remap)
+    {
+      instance.m_localeCache.clear();
+      instance.m_localeCacheStats.locales = instance.m_localeCacheStats.bytes = 0;
+      instance.loadDefaultDictionary();
+      const std::string locale = instance.m_snapshot->requested;
+      instance.publish(locale, instance.loadDictionary(locale));
+    }
+  }
+  if (enabled) instance.m_reloadThread = std::thread(&i18n::reloadLoop, &instance);
+  return true;
+#else
+  (void)enabled;
+  return false;
+#endif
+}
+
+inline void i18n::reloadLoop()
+{
+#ifdef __linux__
+  const int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (fd < 0) return;
+  std::filesystem::path watched;
+  int watch = -1;
+  std::vector<std::string> changed;
+  alignas(inotify_event) char events[4096];
+  while (!m_reloadStop)
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex); // Init may have moved the locale directory
+      if (m_localePath != watched)
+      {
+        if (watch >= 0) inotify_rm_watch(fd, watch);
+        watched = m_localePath;
+        watch = inotify_add_watch(fd, watched.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE);
+      }
+    }
+    // Wake up now and then to notice a stop request or a new directory. Editors touch a file several
+    // times per save, so events are collected until the directory has been quiet for a moment.
+    pollfd pending {fd, POLLIN, 0};
+    if (poll(&pending, 1, changed.empty() ? 200 : 50) > 0)
+    {
+      for (ssize_t length; (length = read(fd, events, sizeof(events))) > 0;)
+        for (char* at = events; at < events + length; at += sizeof(inotify_event) + reinterpret_cast<inotify_event*>(at)->len)
+        {
+          const inotify_event* event = reinterpret_cast<inotify_event*>(at);
+          if (event->len && std::find(changed.begin(), changed.end(), event->name) == changed.end()) changed.emplace_back(event->name);
+        }
+      continue;
+    }
+    if (changed.empty()) continue;
+    reloadFiles(changed);
+    changed.clear();
+  }
+  close(fd);
+#endif
+}
+
+inline void i18n::reloadFiles(const std::vector<std::string>& files)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto changed = [&](const locale_catalog& loaded) {
+    if (loaded.directory != m_localePath) return false; // Overlay directories aren't watched
+    return std::find(files.begin(), files.end(), getLocalePath(loaded.locale, loaded.directory).filename().string()) != files.end()
+      || std::find(files.begin(), files.end(), getCompiledLocalePath(loaded.locale, loaded.directory).filename().string()) != files.end();
+  };
+
+  // Reload the changed files of the published chain, the other catalogs are shared as they are
+  const std::shared_ptr<const snapshot> current = m_snapshot;
+  std::vector<locale_catalog> catalogs = current->catalogs;
+  std::vector<std::string> reloaded;
+  bool republish = false;
+  for (auto it = catalogs.begin(); it != catalogs.end();)
+  {
+    if (!changed(*it)) { ++it; continue; }
+    reloaded.push_back(it->locale);
+    std::shared_ptr<const dictionary> catalog = readDictionary(it->directory, it->locale);
+    if (catalog && catalog->sameEntries(*it->catalog)) { ++it; continue; }
+    republish = true;
+    if (!catalog) { it = catalogs.erase(it); continue; } // Deleted
+    it->catalog = std::move(catalog);
+    ++it;
+  }
+
+  // A file of the chain may have been created since it was loaded, e.g. deleted and written again by an
+  // editor. It goes after its locale's overlays and before the parent locales' catalogs.
+  std::vector<std::string> levels;
+  for (const std::string& level : getLocaleChain(current->requested))
+  {
+    if (level == m_defaultLocale) break;
+    levels.push_back(level);
+  }
+  levels.push_back(m_defaultLocale);
+  for (std::size_t level = 0; level < levels.size(); ++level)
+  {
+    locale_catalog created {levels[level], m_localePath, nullptr};
+    if (!changed(created) || std::any_of(catalogs.begin(), catalogs.end(), [&](const locale_catalog& loaded) { return loaded.locale == created.locale && loaded.directory == created.directory; }))
+      continue;
+    if (!(created.catalog = readDictionary(created.directory, created.locale))) continue;
+    const auto parents = std::find_if(catalogs.begin(), catalogs.end(), [&](const locale_catalog& loaded) { return std::find(levels.begin() + level + 1, levels.end(), loaded.locale) != levels.end(); });
+    catalogs.insert(parents, std::move(created));
+    reloaded.push_back(levels[level]);
+    republish = true;
+  }
+
+  // Only the default locale's catalogs have its name, chains stop before it
+  const auto defaultBegin = std::find_if(catalogs.begin(), catalogs.end(), [this](const locale_catalog& loaded) { return loaded.locale == m_defaultLocale; });
+  m_defaultCatalogs.assign(defaultBegin, catalogs.end());
+
+  // Cached locales that changed on disk take the reloaded catalogs, or are loaded again when they are used next
+  for (auto it = m_localeCache.begin(); it != m_localeCache.end();)
+  {
+    bool stale = std::any_of(it->catalogs.begin(), it->catalogs.end(), changed) || std::find(reloaded.begin(), reloaded.end(), it->locale) != reloaded.end();
+    if (!stale) { ++it; continue; }
+    m_localeCacheStats.bytes -= it->bytes;
+    if (std::find(reloaded.begin(), reloaded.end(), it->locale) == reloaded.end())
+    {
+      it = m_localeCache.erase(it);
+      continue;
+    }
+    it->catalogs.clear();
+    it->bytes = 0;
+    it->resolved = nullptr;
+    for (const locale_catalog& loaded : catalogs)
+      if (loaded.locale == it->locale)
+      {
+        it->catalogs.push_back(loaded);
+        it->bytes += loaded.catalog->bytes();
+      }
+    m_localeCacheStats.bytes += it->bytes;
+    ++it;
+  }
+  m_localeCacheStats.locales = m_localeCache.size();
+
+  // Merged tables kept with cached locales may hold a replaced catalog, they are built again when used
+  if (republish || !reloaded.empty())
+    for (cached_locale& cached : m_localeCache)
+      if (cached.resolved)
+      {
+        cached.bytes -= cached.resolved->bytes();
+        m_localeCacheStats.bytes -= cached.resolved->bytes();
+        cached.resolved = nullptr;
+      }
+
+  if (republish) publish(current->requested, std::vector<locale_catalog>(catalogs.begin(), defaultBegin));
+}
+
+inline void i18n::republish()
+{
+  const std::shared_ptr<const snapshot> current = m_snapshot;
+  publish(current->requested, std::vector<locale_catalog>(current->catalogs.begin(), current->catalogs.end() - current->defaultCatalogs));
+}
+
+inline i18n::reader::reader(i18n& instance) : instance(instance)
+{
+  std::lock_guard<std::mutex> lock(instance.m_readersMutex);
+  instance.m_readers.push_back(this);
+}
+
+inline i18n::reader::~reader()
+{
+  std::lock_guard<std::mutex> lock(instance.m_readersMutex);
+  instance.m_readers.erase(std::remove(instance.m_readers.begin(), instance.m_readers.end(), this), instance.m_readers.end());
+}
+
+inline i18n::reader& i18n::threadReader()
+{
+  thread_local reader t_reader(*this);
+  return t_reader;
+}
+
+inline i18n::snapshot_guard i18n::acquire()
+{
+  // The generation is announced before the pointer is read, so a publish that doesn't see it yet has
+  // already replaced the pointer. No lock and no reference count, the snapshot is freed by reclaim().
+  // A polling thread keeps the epoch of its first lookup since it last polled.
+  reader& reader = threadReader();
+  if (reader.depth++ == 0 && !reader.epoch.load(std::memory_order_relaxed)) reader.epoch.store(m_generation.load(std::memory_order_acquire), std::memory_order_seq_cst);
+  return snapshot_guard(reader, *m_current.load(std::memory_order_seq_cst));
+}
+
+inline void i18n::Poll()
+{
+  i18n& instance = GetInstance();
+  reader& reader = instance.threadReader();
+  reader.polling = true;
+  if (reader.depth) return; // From inside a lookup, e.g. a formatter
+  const std::uint64_t epoch = reader.epoch.exchange(0, std::memory_order_release);
+  // Locales replaced since this thread's first lookup may only have been waiting for it. A writer that
+  // holds the lock frees them when it publishes.
+  if (epoch && epoch != instance.m_generation.load(std::memory_order_acquire))
+  {
+    std::unique_lock<std::mutex> lock(instance.m_mutex, std::try_to_lock);
+    if (lock) instance.reclaim();
+  }
+}
+
+inline void i18n::reclaim()
+{
+  // A lookup that started at an epoch of at least the replacing generation read a newer pointer
+  std::uint64_t oldest = std::numeric_limits<std::uint64_t>::max();
+  {
+    std::lock_guard<std::mutex> lock(m_readersMutex);
+    for (const reader* reader : m_readers)
+      if (const std::uint64_t epoch = reader->epoch.load(std::memory_order_seq_cst)) oldest = std::min(oldest, epoch);
+  }
+  m_retired.erase(std::remove_if(m_retired.begin(), m_retired.end(), [oldest](const retired_snapshot& retired) { return retired.generation <= oldest; }), m_retired.end());
+}
+
+inline void i18n::publish(std::string locale, std::vector<locale_catalog> chain)
+{
+  auto next = std::make_shared<snapshot>();
+  next->requested = locale;
+  next->locale = chain.empty() ? m_defaultLocale : std::move(locale); // Fall back to the default locale if no locale file of the chain exists
+  next->defaultNS = m_defaultNS;
+  next->defaultNSHash = hashString(m_defaultNS);
+  next->catalogs = std::move(chain);
+  next->catalogs.insert(next->catalogs.end(), m_defaultCatalogs.begin(), m_defaultCatalogs.end());
+  next->defaultCatalogs = m_defaultCatalogs.size();
+  // Merging is O(entries), so a table built for the same catalogs is reused: the current one if only
+  // the settings changed, or the one kept with a cached locale on a switch back
+  if (next->catalogs.size() > 1)
+  {
+    std::vector<std::shared_ptr<const dictionary>> sources;
+    for (const locale_catalog& loaded : next->catalogs) sources.push_back(loaded.catalog);
+    if (m_snapshot->resolved && m_snapshot->resolved->sources() == sources)
+      next->resolved = m_snapshot->resolved;
+    for (const cached_locale& cached : m_localeCache)
+      if (!next->resolved && cached.resolved && cached.resolved->sources() == sources)
+        next->resolved = cached.resolved;
+    auto owner = std::find_if(m_localeCache.begin(), m_localeCache.end(), [&next](const cached_locale& entry) { return entry.locale == next->catalogs.front().locale; });
+    if (!next->resolved && (next->resolved = resolved_table::build(std::move(sources))) && owner != m_localeCache.end())
+    {
+      const std::size_t replaced = owner->resolved ? owner->resolved->bytes() : 0;
+      owner->resolved = next->resolved;
+      owner->bytes += next->resolved->bytes() - replaced;
+      m_localeCacheStats.bytes += next->resolved->bytes() - replaced;
+      trimLocaleCache();
+    }
+  }
+  next->messages.reserve(m_messageTable.size());
+  for (const key& key : m_messageTable)
+  {
+    const std::string_view ns = key.m_hash ? key.m_ns : std::string_view(next->defaultNS);
+    message found = IFind(*next, key.m_hash ? key.m_hash : hashKey(next->defaultNSHash, key.m_msgidHash), ns, key.m_msgid, true);
+    next->messages.push_back(found.msgstr.data() ? found : message{key.m_msgid});
+  }
+  if (m_missCacheSize)
+  {
+    next->missCache = std::make_unique<std::atomic<std::uint64_t>[]>(m_missCacheSize);
+    next->missCacheMask = m_missCacheSize - 1;
+  }
+  m_current.store(next.get(), std::memory_order_seq_cst);
+  const std::uint64_t generation = m_generation.fetch_add(1, std::memory_order_seq_cst) + 1;
+  m_retired.push_back({generation, std::exchange(m_snapshot, std::move(next))});
+  reclaim(); // Usually frees the replaced snapshot right away, lookups are short
+}
+
+template<typename... Types>
+inline std::string i18n::IFormat(const message& message, const Types&... args)
+{
+  if constexpr (sizeof...(Types) == 0)
+    return std::string(message.msgstr);
+  else
+  {
+    if (!message.format) return i18n_vformat(message.msgstr, i18n_make_format_args(args...)); // Sized by the formatter, no back_inserter
+    // Literals are appended in one go, a back_inserter would push them one char at a time
+    auto formatArgs = i18n_make_format_args(args...);
+    std::string str;
+    str.reserve(message.msgstr.size() + 16);
+    for (const format_segment* segment = message.format; segment != message.format + message.formatLen; ++segment)
+    {
+      const char* text = message.strings + segment->offset;
+      if (segment->kind == format_segment::LITERAL)
+      {
+        str.append(text, segment->length);
+        continue;
+      }
+      std::int32_t index = 0;
+      bool found = ((index++ == segment->arg ? (formatField(std::back_inserter(str), *segment, message.strings, args, formatArgs), true) : false) || ...);
+      if (!found) i18n_vformat_to(std::back_inserter(str), std::string_view(text, segment->length), formatArgs); // Reports the missing argument
+    }
+    return str;
+  }
+}
+
+template<typename OutputIt, typename... Types>
+inline OutputIt i18n::IFormatTo(OutputIt out, const message& message, const Types&... args)
+{
+  if constexpr (sizeof...(Types) == 0)
+    return std::copy(message.msgstr.begin(), message.msgstr.end(), out);
+  else
+  {
+    auto formatArgs = i18n_make_format_args(args...);
+    if (!message.format) return i18n_vformat_to(out, message.msgstr, formatArgs); // The format string is only known at runtime
+    // Literal text is copied as is and each field is formatted straight from its argument
+    for (const format_segment* segment = message.format; segment != message.format + message.formatLen; ++segment)
+    {
+      const char* text = message.strings + segment->offset;
+      if (segment->kind == format_segment::LITERAL)
+      {
+        out = std::copy(text, text + segment->length, out);
+        continue;
+      }
+      std::int32_t index = 0;
+      bool found = ((index++ == segment->arg ? (out = formatField(out, *segment, message.strings, args, formatArgs), true) : false) || ...);
+      if (!found) out = i18n_vformat_to(out, std::string_view(text, segment->length), formatArgs); // Reports the missing argument
+    }
+    return out;
+  }
+}
+
+template<typename OutputIt, typename Type, typename FormatArgs>
+inline OutputIt i18n::formatField(OutputIt out, const format_segment& segment, const char* strings, const Type& value, const FormatArgs& formatArgs)
+{
+  // Common fields skip the formatter and its spec parsing, they print exactly what format would
+  constexpr bool isInteger = std::is_integral_v<Type> && !std::is_same_v<Type, bool> && !std::is_same_v<Type, char>;
+  constexpr bool isString = std::is_convertible_v<const Type&, std::string_view>;
+  char buffer[64];
+  std::to_chars_result result {};
+  if constexpr (isInteger)
+  {
+    if (segment.kind == format_segment::DEFAULT)
+      result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+  }
+  else if constexpr (std::is_floating_point_v<Type>)
+  {
+    if (segment.kind == format_segment::FIXED)
+      result = std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::fixed, segment.precision);
+  }
+  else if constexpr (isString)
+  {
+    if (segment.kind == format_segment::DEFAULT)
+    {
+      std::string_view str = value;
+      return std::copy(str.begin(), str.end(), out);
+    }
+  }
+  if (result.ptr && result.ec == std::errc()) return std::copy(buffer, result.ptr, out);
+  return i18n_vformat_to(out, std::string_view(strings + segment.offset, segment.length), formatArgs);
+}
+
+inline i18n::message i18n::ILookup(const snapshot& snapshot, std::string_view ns, std::string_view msgid)
+{
+  return IResolve(snapshot, hashKey(hashString(ns), hashString(msgid)), ns, msgid, true);
+}
+
+inline i18n::message i18n::ILookup(const snapshot& snapshot, const key& key)
+{
+  if (key.m_hash) return IResolve(snapshot, key.m_hash, key.m_ns, key.m_msgid, false);
+  return IResolve(snapshot, hashKey(snapshot.defaultNSHash, key.m_msgidHash), snapshot.defaultNS, key.m_msgid, false); // Only the default namespace hash is mixed in at runtime
+}
+
+inline i18n::message i18n::ILookup(const snapshot& snapshot, std::string_view ns, const key& key)
+{
+  return IResolve(snapshot, hashKey(hashString(ns), key.m_msgidHash), ns, key.m_msgid, false);
+}
+
+template<typename... Types>
+inline auto i18n::TranslateCached(site_cache& site, const key& key, const Types&... args) {
+  i18n& instance = GetInstance();
+  if constexpr (sizeof...(Types) == 0)
+    return instance.ICached(site, key).msgstr;
+  else
+  {
+    const snapshot_guard snapshot = instance.acquire(); // Keeps the catalogs while formatting
+    return instance.IFormat(instance.ICached(site, key), args...);
+  }
+}
+
+inline i18n::message i18n::IFind(const snapshot& snapshot, std::uint64_t hash, std::string_view ns, std::string_view msgid, bool verifyText)
+{
+  if (snapshot.resolved) return snapshot.resolved->find(hash, ns, msgid, verifyText); // The whole fallback chain merged, one probe whichever catalog has the key
+  for (const locale_catalog& loaded : snapshot.catalogs) // Most specific first, ending with the default locale
+  {
+    message translation = loaded.catalog->find(hash, ns, msgid, verifyText);
+    if (translation.msgstr.data()) return translation;
+  }
+  return {};
+}
+
+inline const i18n::message& i18n::IMessage(const snapshot& snapshot, message_id id)
+{
+  static const message unknown {std::string_view("", 0)}; // E.g. an ID from a table that isn't registered yet
+  const std::size_t index = static_cast<std::size_t>(id);
+  return index < snapshot.messages.size() ? snapshot.messages[index] : unknown;
+}
+
+inline const i18n::message& i18n::ICached(site_cache& site, const key& key)
+{
+  // The generation only moves forward, so if it still matches, the message points into the published
+  // snapshot. The caller holds a guard if it reads more than the view. A polling thread's first lookup
+  // since it polled still takes one, which keeps the snapshot until it polls again.
+  if (reader& reader = threadReader(); reader.polling && !reader.depth && !reader.epoch.load(std::memory_order_relaxed)) acquire();
+  const std::uint64_t generation = m_generation.load(std::memory_order_acquire);
+  if (generation == site.m_generation) return site.m_message;
+  site.m_message = ILookup(acquire(), key);
+  site.m_generation = generation; // acquire() may have read a newer one, then the next call resolves again
+  return site.m_message;
+}
+
+inline i18n::message i18n::IResolve(const snapshot& snapshot, std::uint64_t hash, std::string_view ns, std::string_view msgid, bool verifyText)
+{
+  if (snapshot.catalogs.empty()) return message{msgid}; // No locale file, nothing to look up
+
+  std::atomic<std::uint64_t>* missSlot = snapshot.missCache ? &snapshot.missCache[hash & snapshot.missCacheMask] : nullptr;
+  if (missSlot && missSlot->load(std::memory_order_relaxed) == hash)
+  {
+    m_misses.fetch_add(1, std::memory_order_relaxed);
+    return message{msgid}; // Known miss
+  }
+
+  message translation = IFind(snapshot, hash, ns, msgid, verifyText);
+  if (translation.msgstr.data()) return translation;
+
+  // Misses never touch the dictionaries, only the bounded cache and the counter
+  if (missSlot) missSlot->store(hash, std::memory_order_relaxed);
+  m_misses.fetch_add(1, std::memory_order_relaxed);
+  return message{msgid};
+}
+
+inline i18n::dictionary i18n::parseDictionary(std::filesystem::path locale_path, std::string_view defaultNS, std::size_t threads, std::shared_ptr<std::pmr::memory_resource> arena, bool internText)
+{
+  // Parse the whole file in place, the dictionary copies out what it keeps
+  mapped_file mapping(locale_path);
+  std::string buffer;
+  std::string_view text(mapping.data(), mapping.size());
+  if (!mapping.data()) // Empty or unmappable files
+  {
+    std::ifstream file (locale_path, std::ios::binary);
+    buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    text = buffer;
+  }
+  threads = std::min(threads, text.size() / parseChunkMinSize);
+  if (threads > 1) return parseParallel(text, defaultNS, threads, std::move(arena), internText);
+  dictionary dictionary(std::move(arena), internText);
+  parseBuffer(text, defaultNS, dictionary);
+  dictionary.seal();
+  return dictionary;
+}
+
+inline i18n::dictionary i18n::parseParallel(std::string_view text, std::string_view defaultNS, std::size_t threads, std::shared_ptr<std::pmr::memory_resource> arena, bool internText)
+{
+  // Cut right after "msgstr:" lines. They reset the namespace and msgid, so every chunk starts in the
+  // same state as the file does and parses exactly as it would in one pass.
+  std::vector<std::string_view> chunks;
+  std::size_t begin = 0;
+  for (std::size_t chunk = 1; chunk < threads; ++chunk)
+  {
+    const std::size_t at = text.find("\nmsgstr:", std::max(begin, text.size() / threads * chunk));
+    const std::size_t eol = at == std::string_view::npos ? at : text.find('\n', at + 1);
+    if (eol == std::string_view::npos) break;
+    chunks.push_back(text.substr(begin, eol + 1 - begin));
+    begin = eol + 1;
+  }
+  chunks.push_back(text.substr(begin));
+
+  // Heap allocated, an arena isn't thread-safe and these are temporary. Their text is interned when
+  // they are merged, the pool has to span the whole file.
+  std::vector<dictionary> parts;
+  for (std::size_t chunk = 0; chunk < chunks.size(); ++chunk) parts.emplace_back(nullptr);
+  std::vector<std::exception_ptr> errors(chunks.size());
+  std::vector<std::thread> workers;
+  auto parse = [&](std::size_t chunk) {
+    try { parseBuffer(chunks[chunk], defaultNS, parts[chunk]); }
+    catch (...) { errors[chunk] = std::current_exception(); }
+  };
+  for (std::size_t chunk = 1; chunk < chunks.size(); ++chunk) workers.emplace_back(parse, chunk);
+  parse(0);
+  for (std::thread& worker : workers) worker.join();
+  for (const std::exception_ptr& error : errors) if (error) std::rethrow_exception(error);
+
+  // Merge in file order, so a key defined in several chunks keeps its last definition
+  std::size_t entries = 0, stringBytes = 0;
+  for (const dictionary& part : parts)
+  {
+    entries += part.size();
+    stringBytes += part.stringsSize();
+  }
+  dictionary dictionary(std::move(arena), internText);
+  dictionary.reserve(entries, stringBytes);
+  for (std::size_t part = 0; part < parts.size(); ++part)
+  {
+    dictionary.merge(parts[part]);
+    parts[part].clear();
+  }
+  dictionary.seal();
+  return dictionary;
+}
+
+template<typename OnEntry>
+inline void i18n::scanEntries(std::string_view text, std::string_view defaultNS, OnEntry&& onEntry)
+{
+  enum lineType { NS, MSG_ID, MSG_STR };
+  std::string_view ns_cache, msgid_cache;
+  std::uint64_t nsHash = hashString({});
+  lineType prev_type = MSG_STR;
+  std::size_t record = 0; // Where the parser state was last reset
+
+  auto value = [](std::string_view line, std::size_t prefix) { // Text after the prefix, without leading spaces
+    std::size_t begin = line.find_first_not_of(' ', prefix);
+    return begin == std::string_view::npos ? std::string_view() : line.substr(begin);
+  };
+
+  const char* it = text.data();
+  const char* const end = text.data() + text.size();
+  while (it < end)
+  {
+    const char* eol = static_cast<const char*>(std::memchr(it, '\n', end - it));
+    if (!eol) eol = end;
+    std::string_view line(it, eol - it);
+    it = eol + 1;
+    if (!line.empty() && line.back() == '\r') line.remove_suffix(1); // Files saved with CRLF line endings
+
+    if (line.size() < 3) continue;
+    switch (line[0]) // Most lines can be told apart by their first character
+    {
+    case 'n':
+      if (line.compare(0, 3, "ns:") != 0) break;
+      msgid_cache = {};
+      ns_cache = value(line, 3);
+      nsHash = hashString(ns_cache);
+      prev_type = NS;
+      break;
+    case 'm':
+      if (line.compare(0, 6, "msgid:") == 0)
+      {
+        msgid_cache = value(line, 6);
+        if (prev_type != NS)
+        {
+          ns_cache = defaultNS;
+          nsHash = hashString(defaultNS);
+        }
+        prev_type = MSG_ID;
+      }
+      else if (line.compare(0, 7, "msgstr:") == 0)
+      {
+        const std::size_t next = std::min<std::size_t>(it - text.data(), text.size());
+        onEntry(nsHash, ns_cache, msgid_cache, value(line, 7), record, next);
+        record = next;
+        ns_cache = {};
+        nsHash = hashString({});
+        msgid_cache = {};
+        prev_type = MSG_STR;
+      }
+      break;
+    }
+  }
+}
+
+inline void i18n::parseBuffer(std::string_view text, std::string_view defaultNS, dictionary& dictionary)
+{
+  // Entries are inserted a few behind the parser, after their slot has been prefetched.
+  // They still go in in file order, so a later duplicate key wins as before.
+  struct entry { std::uint64_t hash; std::string_view ns, msgid, msgstr; };
+  constexpr std::size_t pipelineDepth = 8;
+  entry pending[pipelineDepth];
+  std::size_t parsed = 0, inserted = 0;
+  auto insertPending = [&] {
+    const entry& e = pending[inserted++ % pipelineDepth];
+    dictionary.insert(e.hash, e.ns, e.msgid, e.msgstr);
+  };
+
+  // One entry per "msgstr:" line, so the slots are allocated once whatever separates the entries: in an
+  // arena a grown-out slot array stays allocated until the locale is freed. The strings only outgrow the
+  // file with many pre-parsed fields, whose text is stored a second time.
+  std::size_t entries = text.compare(0, 7, "msgstr:") == 0;
+  for (std::size_t at = 0; (at = text.find("\nmsgstr:", at)) != std::string_view::npos; ++at) ++entries;
+  dictionary.reserve(dictionary.size() + entries, dictionary.stringsSize() + text.size());
+
+  scanEntries(text, defaultNS, [&](std::uint64_t nsHash, std::string_view ns, std::string_view msgid, std::string_view msgstr, std::size_t, std::size_t) {
+    if (parsed - inserted == pipelineDepth) insertPending();
+    entry& e = pending[parsed++ % pipelineDepth];
+    e = {hashKey(nsHash, hashString(msgid)), ns, msgid, msgstr};
+    dictionary.prefetch(e.hash);
+  });
+  while (inserted < parsed) insertPending();
+}
+
+inline void i18n::loadDefaultDictionary()
+{
+  m_defaultCatalogs = readCatalogs(m_defaultLocale);
+}
+
+inline std::vector<i18n::locale_catalog> i18n::loadDictionary(const std::string locale)
+{
+  std::vector<locale_catalog> chain;
+  for (const std::string& level : getLocaleChain(locale))
+  {
+    if (level == m_defaultLocale) break; // Loaded already, and always last
+    std::vector<locale_catalog> catalogs = loadCatalogs(level);
+    chain.insert(chain.end(), std::make_move_iterator(catalogs.begin()), std::make_move_iterator(catalogs.end()));
+  }
+  return chain;
+}
+
+inline std::vector<i18n::locale_catalog> i18n::loadCatalogs(const std::string& locale)
+{
+  auto cached = std::find_if(m_localeCache.begin(), m_localeCache.end(), [&locale](const cached_locale& entry) { return entry.locale == locale; });
+  if (cached != m_localeCache.end())
+  {
+    ++m_localeCacheStats.hits;
+    std::rotate(m_localeCache.begin(), cached, cached + 1); // Move to the front
+    return m_localeCache.front().catalogs;
+  }
+  std::vector<locale_catalog> catalogs = readCatalogs(locale);
+  if (!m_localeCacheLocales || catalogs.empty()) return catalogs; // Parent locales without a file aren't counted
+  ++m_localeCacheStats.misses;
+  std::size_t bytes = 0;
+  for (const locale_catalog& loaded : catalogs) bytes += loaded.catalog->bytes();
+  m_localeCache.insert(m_localeCache.begin(), {locale, catalogs, bytes});
+  m_localeCacheStats.bytes += bytes;
+  trimLocaleCache();
+  return catalogs;
+}
+
+inline std::vector<i18n::locale_catalog> i18n::readCatalogs(const std::string& locale)
+{
+  std::vector<locale_catalog> catalogs;
+  for (auto it = m_overlayPaths.rbegin(); it != m_overlayPaths.rend(); ++it)
+    if (std::shared_ptr<const dictionary> catalog = readDictionary(*it, locale)) catalogs.push_back({locale, *it, std::move(catalog)});
+  if (std::shared_ptr<const dictionary> catalog = readDictionary(m_localePath, locale)) catalogs.push_back({locale, m_localePath, std::move(catalog)});
+  return catalogs;
+}
+
+inline void i18n::trimLocaleCache()
+{
+  // A locale over the byte budget on its own isn't kept at all, the snapshot holds it while it's in use
+  while (!m_localeCache.empty() && (m_localeCache.size() > m_localeCacheLocales || (m_localeCacheBytes && m_localeCacheStats.bytes > m_localeCacheBytes)))
+  {
+    m_localeCacheStats.bytes -= m_localeCache.back().bytes;
+    m_localeCache.pop_back();
+    ++m_localeCacheStats.evictions;
+  }
+  m_localeCacheStats.locales = m_localeCache.size();
+}
+
+inline std::shared_ptr<const i18n::dictionary> i18n::readDictionary(const std::filesystem::path& directory, const std::string& locale)
+{
+  if (auto embedded = m_embeddedCatalogs.find(locale); embedded != m_embeddedCatalogs.end() && directory == m_localePath)
+  {
+    auto image = std::make_shared<dictionary>();
+    if (image->map(embedded->second.data(), embedded->second.size(), m_defaultNS)) return image;
+  }
+  std::filesystem::path locale_path = getLocalePath(locale, directory);
+  std::filesystem::path compiled_path = getCompiledLocalePath(locale, directory);
+  const bool copy = m_copyFiles && directory == m_localePath; // A watched file may be rewritten in place
+  std::error_code ec;
+  const bool text_exists = std::filesystem::exists(locale_path, ec);
+  if (std::filesystem::exists(compiled_path, ec))
+  {
+    // Prefer the compiled catalog unless the text file was edited after it was built
+    if (!text_exists || std::filesystem::last_write_time(compiled_path, ec) >= std::filesystem::last_write_time(locale_path, ec))
+    {
+      auto compiled = std::make_shared<dictionary>(makeArena());
+      if ((!copy && compiled->map(compiled_path, m_defaultNS)) || compiled->load(compiled_path, m_defaultNS)) return compiled;
+    }
+  }
+  if (!text_exists) return nullptr;
+  if (m_lazyNamespaces)
+  {
+    auto lazy = std::make_shared<dictionary>(makeArena(), m_internStrings);
+    if (lazy->openLazy(locale_path, m_defaultNS, m_lazyIndexFile ? getIndexLocalePath(locale, directory) : std::filesystem::path(), copy)) return lazy;
+  }
+  return std::make_shared<const dictionary>(parseDictionary(locale_path, m_defaultNS, m_parseThreads, makeArena(), m_internStrings));
+}
+
+inline std::shared_ptr<std::pmr::memory_resource> i18n::makeArena()
+{
+  return std::make_shared<std::pmr::monotonic_buffer_resource>(m_memoryResource ? m_memoryResource : std::pmr::get_default_resource());
+}
+
+inline std::vector<std::string> i18n::getLocaleChain(std::string_view locale)
+{
+  std::vector<std::string> chain;
+  while (!locale.empty())
+  {
+    chain.emplace_back(locale);
+    std::size_t separator = locale.find_last_of("-_");
+    if (separator == std::string_view::npos) break;
+    locale = locale.substr(0, separator);
+    separator = locale.find_last_of("-_");
+    if (locale.size() - (separator == std::string_view::npos ? 0 : separator + 1) == 1) // A singleton never ends a tag
+      locale = locale.substr(0, separator == std::string_view::npos ? 0 : separator);
+  }
+  return chain;
+}
+
+inline std::filesystem::path i18n::getLocalePath(std::string locale, const std::filesystem::path& directory)
+{
+  std::string locale_filename = locale + m_localeExtension;
+  return (directory / locale_filename);
+}
+
+inline std::filesystem::path i18n::getCompiledLocalePath(std::string locale, const std::filesystem::path& directory)
+{
+  std::string locale_filename = locale + m_localeExtension + "c";
+  return (directory / locale_filename);
+}
+
+inline std::filesystem::path i18n::getIndexLocalePath(std::string locale, const std::filesystem::path& directory)
+{
+  std::string locale_filename = locale + m_localeExtension + "i";
+  return (directory / locale_filename);
+}
+
+inline i18n::mapped_file::mapped_file(const std::filesystem::path& path, bool copy)
+{
+  if (copy)
+  {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    const std::streamoff size = file ? static_cast<std::streamoff>(file.tellg()) : 0;
+    if (size <= 0) return;
+    m_copy = std::make_unique<char[]>(static_cast<std::size_t>(size));
+    file.seekg(0);
+    if (!file.read(m_copy.get(), size)) return;
+    m_data = m_copy.get();
+    m_size = static_cast<std::size_t>(size);
+    return;
+  }
+#ifdef _WIN32
+  HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) return;
+  LARGE_INTEGER size {};
+  HANDLE mapping = GetFileSizeEx(file, &size) && size.QuadPart ? CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+  if (mapping)
+  {
+    m_data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (m_data) m_size = static_cast<std::size_t>(size.QuadPart);
+    CloseHandle(mapping); // The view keeps the mapping alive
+  }
+  CloseHandle(file);
+#else
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return;
+  struct stat info {};
+  if (fstat(fd, &info) == 0 && info.st_size > 0)
   {
-    if (line.find("ns:") == 0)
+    void* data = mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    if (data != MAP_FAILED)
     {
-      line.erase(0, 3);
-      while (line.find(" ") == 0) line.erase(0, 1);
-      msgid_cache.clear();
-      ns_cache = line;
-      prev_type = NS;
+      m_data = static_cast<const char*>(data);
+      m_size = static_cast<std::size_t>(info.st_size);
+    }
+  }
+  close(fd); // The mapping stays valid
+#endif
+}
+
+inline i18n::mapped_file::~mapped_file()
+{
+  if (!m_data || m_borrowed || m_copy) return;
+#ifdef _WIN32
+  UnmapViewOfFile(m_data);
+#else
+  munmap(const_cast<char*>(m_data), m_size);
+#endif
+}
+
+inline i18n::dictionary& i18n::dictionary::operator=(dictionary other) noexcept
+{
+  m_storage = std::move(other.m_storage);
+  m_mapping = std::move(other.m_mapping);
+  m_lazy = std::move(other.m_lazy);
+  m_view = other.m_view;
+  m_size = other.m_size;
+  m_internText = other.m_internText;
+  m_internedBytes = other.m_internedBytes;
+  m_interned = std::move(other.m_interned); // Offsets into the strings that were just replaced
+  m_internedCount = other.m_internedCount;
+  rebind();
+  return *this;
+}
+
+inline void i18n::dictionary::rebind()
+{
+  if (m_mapping) return; // Views into the mapping stay valid, only owned storage moves
+  m_view.slots = m_storage.slots.data();
+  m_view.slotCount = m_storage.slots.size();
+  m_view.format = m_storage.format.data();
+  m_view.formatCount = m_storage.format.size();
+  m_view.strings = m_storage.strings.data();
+  m_view.stringsSize = m_storage.strings.size();
+  m_view.displacements = m_storage.displacements.data();
+  m_view.bucketCount = m_storage.displacements.size();
+}
+
+inline void i18n::dictionary::insert(std::string_view ns, std::string_view msgid, std::string_view msgstr)
+{
+  insert(hashKey(hashString(ns), hashString(msgid)), ns, msgid, msgstr);
+}
+
+inline void i18n::dictionary::insert(std::uint64_t hash, std::string_view ns, std::string_view msgid, std::string_view msgstr)
+{
+  assert(!m_mapping && !m_view.bucketCount && "i18n: mapped and compiled dictionaries are read-only");
+  assert(hash == hashKey(hashString(ns), hashString(msgid)));
+  std::pmr::vector<slot>& slots = m_storage.slots;
+  const std::pmr::string& strings = m_storage.strings;
+  if ((m_size + 1) * 4 > slots.size() * 3) grow(slots.empty() ? 16 : slots.size() * 2); // Keep the load factor under 3/4
+  const std::size_t mask = slots.size() - 1;
+  std::size_t i = hash & mask;
+  for (; slots[i].hash; i = (i + 1) & mask)
+  {
+    slot& s = slots[i];
+    if (s.hash == hash && std::string_view(&strings[s.ns], s.nsLen) == ns && std::string_view(&strings[s.msgid], s.msgidLen) == msgid)
+    {
+      s.msgstr = m_internText ? internString(msgstr) : addString(msgstr); // A later entry for the same key wins
+      s.msgstrLen = static_cast<std::uint32_t>(msgstr.size());
+      compileFormat(s);
+      rebind();
+      return;
     }
-    if (line.find("msgid:") == 0)
+  }
+  slot& s = slots[i];
+  s.hash = hash;
+  s.ns = internString(ns);
+  s.nsLen = static_cast<std::uint32_t>(ns.size());
+  s.msgid = m_internText ? internString(msgid) : addString(msgid);
+  s.msgidLen = static_cast<std::uint32_t>(msgid.size());
+  s.msgstr = m_internText ? internString(msgstr) : addString(msgstr);
+  s.msgstrLen = static_cast<std::uint32_t>(msgstr.size());
+  compileFormat(s);
+  ++m_size;
+  rebind();
+}
+
+inline i18n::message i18n::dictionary::find(std::uint64_t hash, std::string_view ns, std::string_view msgid, bool verifyText) const
+{
+  if (m_lazy) return m_lazy->find(hash, ns, msgid, verifyText);
+  if (!m_size || !m_view.slotCount) return {};
+  if (m_view.bucketCount) // The key is in this one slot or nowhere
+  {
+    const std::size_t i = perfectSlot(hash, m_view.displacements[perfectBucket(hash, m_view.bucketCount)], m_view.slotCount);
+    return i < m_view.slotCount ? match(m_view.slots[i], hash, ns, msgid, verifyText) : message{};
+  }
+  const std::size_t mask = m_view.slotCount - 1;
+  std::size_t i = hash & mask;
+  for (std::size_t probes = 0; probes < m_view.slotCount && m_view.slots[i].hash; ++probes, i = (i + 1) & mask)
+  {
+    message found = match(m_view.slots[i], hash, ns, msgid, verifyText);
+    if (found.msgstr.data()) return found;
+  }
+  return {};
+}
+
+inline i18n::message i18n::dictionary::match(const slot& s, std::uint64_t hash, std::string_view ns, std::string_view msgid, bool verifyText) const
+{
+  if (s.hash != hash) return {};
+  // Offsets are only checked here, so mapping a compiled catalog stays O(1) while a damaged one can't read out of bounds
+  if (!inBounds(s)) return {};
+  const char* strings = m_view.strings;
+  const message found {std::string_view(strings + s.msgstr, s.msgstrLen), s.formatLen ? m_view.format + s.format : nullptr, s.formatLen, strings};
+#ifdef NDEBUG
+  if (!verifyText) return found;
+#endif
+  if (std::string_view(strings + s.msgid, s.msgidLen) == msgid && std::string_view(strings + s.ns, s.nsLen) == ns)
+    return found;
+  assert(verifyText && "i18n: hash collision between a compile-time key and a different catalog entry");
+  return {};
+}
+
+inline std::size_t i18n::dictionary::perfectSlot(std::uint64_t hash, std::uint32_t displacement, std::size_t slotCount)
+{
+  if (displacement & 0x80000000u) return displacement & 0x7fffffffu;
+  std::uint64_t x = hash + displacement * 0x9e3779b97f4a7c15ull; // murmur3 finalizer over the displaced hash
+  x = (x ^ (x >> 33)) * 0xff51afd7ed558ccdull;
+  x ^= x >> 33;
+  return static_cast<std::size_t>(((x >> 32) * slotCount) >> 32);
+}
+
+inline bool i18n::dictionary::buildPerfectHash(const std::vector<std::uint64_t>& hashes, std::vector<std::uint32_t>& displacements, std::vector<std::uint32_t>& positions)
+{
+  const std::size_t n = hashes.size();
+  if (!n || n >= 0x80000000u) return false;
+  {
+    std::vector<std::uint64_t> sorted = hashes;
+    std::sort(sorted.begin(), sorted.end());
+    if (std::adjacent_find(sorted.begin(), sorted.end()) != sorted.end()) return false;
+  }
+
+  const std::size_t bucketCount = n / 4 + 1;
+  std::vector<std::uint32_t> start(bucketCount + 1), members(n);
+  for (std::uint64_t hash : hashes) ++start[perfectBucket(hash, bucketCount) + 1];
+  for (std::size_t bucket = 0; bucket < bucketCount; ++bucket) start[bucket + 1] += start[bucket];
+  {
+    std::vector<std::uint32_t> next(start.begin(), start.end() - 1);
+    for (std::uint32_t key = 0; key < n; ++key) members[next[perfectBucket(hashes[key], bucketCount)]++] = key;
+  }
+  std::vector<std::uint32_t> order(bucketCount);
+  for (std::uint32_t bucket = 0; bucket < bucketCount; ++bucket) order[bucket] = bucket;
+  std::stable_sort(order.begin(), order.end(), [&start](std::uint32_t a, std::uint32_t b) { return start[a + 1] - start[a] > start[b + 1] - start[b]; });
+
+  displacements.assign(bucketCount, 0);
+  positions.assign(n, 0);
+  std::vector<bool> taken(n);
+  std::vector<std::size_t> placed;
+  std::size_t nextFree = 0;
+  for (std::uint32_t bucket : order)
+  {
+    const std::uint32_t* keys = members.data() + start[bucket];
+    const std::size_t size = start[bucket + 1] - start[bucket];
+    if (!size) break; // Sorted by size, the rest are empty too
+    if (size == 1)
     {
-      line.erase(0, 6);
-      while (line.find(" ") == 0) line.erase(0, 1);
-      msgid_cache = line;
-      if (prev_type != NS) ns_cache = m_defaultNS;
-      prev_type = MSG_ID;
+      while (taken[nextFree]) ++nextFree;
+      taken[nextFree] = true;
+      positions[keys[0]] = static_cast<std::uint32_t>(nextFree);
+      displacements[bucket] = 0x80000000u | static_cast<std::uint32_t>(nextFree);
+      continue;
     }
-    if (line.find("msgstr:") == 0)
+    for (std::uint32_t displacement = 0;; ++displacement)
     {
-      if (prev_type = MSG_ID)
+      if (displacement == 0x80000000u) return false;
+      placed.clear();
+      for (std::size_t key = 0; key < size; ++key)
+      {
+        const std::size_t slot = perfectSlot(hashes[keys[key]], displacement, n);
+        if (taken[slot] || std::find(placed.begin(), placed.end(), slot) != placed.end()) break;
+        placed.push_back(slot);
+      }
+      if (placed.size() < size) continue;
+      for (std::size_t key = 0; key < size; ++key)
       {
-        line.erase(0,7);
-        while (line.find(" ") == 0) line.erase(0, 1);
-        dictionary[ns_cache][msgid_cache] = line;
+        taken[placed[key]] = true;
+        positions[keys[key]] = static_cast<std::uint32_t>(placed[key]);
       }
-      ns_cache.clear();
-      msgid_cache.clear();
-      prev_type = MSG_STR;
+      displacements[bucket] = displacement;
+      break;
     }
   }
-  file.close();
-  return dictionary;
+  return true;
 }
 
-inline void i18n::loadDefaultDictionary()
+inline void i18n::dictionary::clear()
+{
+  *this = dictionary();
+}
+
+inline bool i18n::dictionary::save(const std::filesystem::path& path, std::string_view defaultNS) const
 {
-  std::filesystem::path defaultLocale_path = getLocalePath(m_defaultLocale);
-  if (!std::filesystem::exists(defaultLocale_path))
+  static_assert(sizeof(slot) == 40 && sizeof(format_segment) == 16 && sizeof(file_header) == 64, "The compiled catalog layout must not depend on the compiler");
+  std::string strings(m_view.strings ? m_view.strings : "", m_view.stringsSize);
+
+  // Lay the entries out by a minimal perfect hash: no empty slots, and a lookup is one probe
+  std::vector<slot> slots(m_view.slots, m_view.slots + m_view.slotCount);
+  std::vector<std::uint32_t> displacements(m_view.displacements, m_view.displacements + m_view.bucketCount);
+  if (!m_view.bucketCount && m_size)
   {
-    m_defaultLocale_exists = false;
-    m_defaultDictionary.clear();
-    return;
+    std::vector<slot> entries;
+    std::vector<std::uint64_t> hashes;
+    entries.reserve(m_size);
+    hashes.reserve(m_size);
+    for (const slot& s : slots)
+      if (s.hash)
+      {
+        entries.push_back(s);
+        hashes.push_back(s.hash);
+      }
+    std::vector<std::uint32_t> positions;
+    if (buildPerfectHash(hashes, displacements, positions)) // Otherwise the probed table is written as it is
+    {
+      slots.assign(entries.size(), slot{});
+      for (std::size_t entry = 0; entry < entries.size(); ++entry) slots[positions[entry]] = entries[entry];
+    }
+  }
+
+  file_header header {};
+  std::memcpy(header.magic, fileMagic, sizeof(header.magic));
+  header.version = fileVersion;
+  header.byteOrder = 0x01020304;
+  header.slotCount = slots.size();
+  header.bucketCount = displacements.size();
+  header.size = m_size;
+  header.formatCount = m_view.formatCount;
+  header.defaultNS = static_cast<std::uint32_t>(strings.size());
+  header.defaultNSLen = static_cast<std::uint32_t>(defaultNS.size());
+  strings.append(defaultNS);
+  strings.push_back('\0');
+  header.stringsSize = strings.size();
+
+  // Write next to the destination and rename over it, so processes that have the old catalog mapped keep their pages
+  std::filesystem::path temp_path = path;
+  temp_path += ".tmp";
+  {
+    std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(slots.data()), slots.size() * sizeof(slot));
+    file.write(reinterpret_cast<const char*>(m_view.format), m_view.formatCount * sizeof(format_segment));
+    file.write(reinterpret_cast<const char*>(displacements.data()), displacements.size() * sizeof(std::uint32_t));
+    file.write(strings.data(), strings.size());
+    if (!file.good()) return false;
+  }
+  std::error_code ec;
+  std::filesystem::rename(temp_path, path, ec);
+  return !ec;
+}
+
+inline bool i18n::dictionary::load(const std::filesystem::path& path, std::string_view defaultNS)
+{
+  std::ifstream file(path, std::ios::binary);
+  std::string image((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  dictionary loaded(m_arena);
+  if (!loaded.attach(image.data(), image.size(), defaultNS)) return false;
+
+  // Copy the sections out of the image into owned storage
+  loaded.m_storage.slots.assign(loaded.m_view.slots, loaded.m_view.slots + loaded.m_view.slotCount);
+  loaded.m_storage.format.assign(loaded.m_view.format, loaded.m_view.format + loaded.m_view.formatCount);
+  loaded.m_storage.displacements.assign(loaded.m_view.displacements, loaded.m_view.displacements + loaded.m_view.bucketCount);
+  loaded.m_storage.strings.assign(loaded.m_view.strings, loaded.m_view.stringsSize);
+  loaded.rebind();
+  *this = std::move(loaded);
+  return true;
+}
+
+inline bool i18n::dictionary::map(const std::filesystem::path& path, std::string_view defaultNS)
+{
+  return map(std::make_shared<const mapped_file>(path), defaultNS);
+}
+
+inline bool i18n::dictionary::map(const char* data, std::size_t size, std::string_view defaultNS)
+{
+  return map(std::make_shared<const mapped_file>(data, size), defaultNS);
+}
+
+inline bool i18n::dictionary::map(std::shared_ptr<const mapped_file> mapping, std::string_view defaultNS)
+{
+  dictionary mapped;
+  if (!mapping->data() || !mapped.attach(mapping->data(), mapping->size(), defaultNS)) return false;
+  mapped.m_mapping = std::move(mapping);
+  *this = std::move(mapped);
+  return true;
+}
+
+inline bool i18n::dictionary::openLazy(const std::filesystem::path& path, std::string_view defaultNS, const std::filesystem::path& indexPath, bool copy)
+{
+  std::shared_ptr<const lazy_index> lazy = lazy_index::open(path, defaultNS, indexPath, m_arena, m_internText, copy);
+  if (!lazy) return false;
+  dictionary opened;
+  opened.m_lazy = std::move(lazy);
+  *this = std::move(opened);
+  return true;
+}
+
+inline std::shared_ptr<const i18n::lazy_index> i18n::lazy_index::open(const std::filesystem::path& path, std::string_view defaultNS, const std::filesystem::path& indexPath, std::shared_ptr<std::pmr::memory_resource> arena, bool internText, bool copy)
+{
+  std::error_code ec;
+  const std::int64_t textTime = static_cast<std::int64_t>(std::filesystem::last_write_time(path, ec).time_since_epoch().count());
+  auto mapping = std::make_shared<const mapped_file>(path, copy);
+  if (ec || !mapping->data()) return nullptr;
+
+  auto index = std::make_shared<lazy_index>();
+  index->m_mapping = std::move(mapping);
+  index->m_defaultNS = defaultNS;
+  index->m_arena = std::move(arena);
+  index->m_internText = internText;
+  if (indexPath.empty() || !index->readIndex(indexPath, index->m_mapping->size(), textTime))
+  {
+    index->build(std::string_view(index->m_mapping->data(), index->m_mapping->size()));
+    if (!indexPath.empty()) index->writeIndex(indexPath, index->m_mapping->size(), textTime);
   }
-  m_defaultLocale_exists = true;
-  m_defaultDictionary = parseDictionary(defaultLocale_path);
+  index->m_loaded = std::make_unique<std::atomic<const dictionary*>[]>(index->m_namespaces.size());
+  index->m_owned.resize(index->m_namespaces.size());
+  return index;
 }
 
-inline void i18n::loadDictionary(const std::string locale)
+inline void i18n::lazy_index::build(std::string_view text)
 {
-  if (locale == m_defaultLocale)
+  // One pass over the file without hashing msgids or copying strings. Records of the same
+  // namespace that follow each other are joined into one range.
+  std::unordered_map<std::string_view, std::size_t> byName;
+  std::string_view lastName;
+  std::size_t last = 0;
+  scanEntries(text, m_defaultNS, [&](std::uint64_t nsHash, std::string_view ns, std::string_view, std::string_view, std::size_t begin, std::size_t end) {
+    if (m_namespaces.empty() || ns != lastName)
+    {
+      auto [found, added] = byName.try_emplace(ns, m_namespaces.size());
+      if (added) m_namespaces.push_back({nsHash, std::string(ns), {}});
+      lastName = ns;
+      last = found->second;
+    }
+    ++m_namespaces[last].entries;
+    std::vector<range>& ranges = m_namespaces[last].ranges;
+    if (!ranges.empty() && ranges.back().end == begin) ranges.back().end = end;
+    else ranges.push_back({begin, end});
+  });
+  std::sort(m_namespaces.begin(), m_namespaces.end(), [](const ns_entry& a, const ns_entry& b) { return a.hash < b.hash; });
+}
+
+inline bool i18n::lazy_index::readIndex(const std::filesystem::path& indexPath, std::uint64_t textSize, std::int64_t textTime)
+{
+  std::ifstream file(indexPath, std::ios::binary);
+  std::string image((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  index_header header {};
+  if (image.size() < sizeof(header)) return false;
+  std::memcpy(&header, image.data(), sizeof(header));
+  if (std::memcmp(header.magic, indexMagic, sizeof(header.magic)) || header.version != indexVersion || header.byteOrder != 0x01020304) return false;
+  if (header.textSize != textSize || header.textTime != textTime) return false; // The catalog changed since the index was written
+  if (header.namespaceCount > image.size() || header.rangeCount > image.size() || header.namesSize > image.size() || header.defaultNSLen > header.namesSize) return false;
+  if (image.size() != sizeof(header) + header.namespaceCount * sizeof(index_namespace) + header.rangeCount * sizeof(range) + header.namesSize) return false;
+
+  const char* namespaces = image.data() + sizeof(header);
+  const char* ranges = namespaces + header.namespaceCount * sizeof(index_namespace);
+  const char* names = ranges + header.rangeCount * sizeof(range);
+  if (std::string_view(names, header.defaultNSLen) != m_defaultNS) return false;
+  std::vector<ns_entry> read(header.namespaceCount);
+  for (std::size_t index = 0; index < read.size(); ++index)
   {
-    m_dictionary.clear();
-    return;
+    index_namespace entry;
+    std::memcpy(&entry, namespaces + index * sizeof(entry), sizeof(entry));
+    if (std::uint64_t(entry.name) + entry.nameLen > header.namesSize || entry.firstRange > header.rangeCount || entry.rangeCount > header.rangeCount - entry.firstRange) return false;
+    read[index].hash = entry.hash;
+    read[index].name.assign(names + entry.name, entry.nameLen);
+    read[index].entries = entry.entries;
+    read[index].ranges.resize(entry.rangeCount);
+    std::memcpy(read[index].ranges.data(), ranges + entry.firstRange * sizeof(range), entry.rangeCount * sizeof(range));
+    for (const range& r : read[index].ranges)
+      if (r.begin > r.end || r.end > textSize) return false;
+    if (read[index].hash != hashString(read[index].name) || (index && read[index].hash < read[index - 1].hash)) return false;
+  }
+  m_namespaces = std::move(read);
+  return true;
+}
+
+inline void i18n::lazy_index::writeIndex(const std::filesystem::path& indexPath, std::uint64_t textSize, std::int64_t textTime) const
+{
+  static_assert(sizeof(index_header) == 64 && sizeof(index_namespace) == 40 && sizeof(range) == 16, "The index layout must not depend on the compiler");
+  index_header header {};
+  std::memcpy(header.magic, indexMagic, sizeof(header.magic));
+  header.version = indexVersion;
+  header.byteOrder = 0x01020304;
+  header.textSize = textSize;
+  header.textTime = textTime;
+  header.namespaceCount = m_namespaces.size();
+  header.defaultNSLen = static_cast<std::uint32_t>(m_defaultNS.size());
+  std::vector<index_namespace> namespaces;
+  std::vector<range> ranges;
+  std::string names = m_defaultNS;
+  for (const ns_entry& entry : m_namespaces)
+  {
+    namespaces.push_back({entry.hash, static_cast<std::uint32_t>(names.size()), static_cast<std::uint32_t>(entry.name.size()), ranges.size(), entry.ranges.size(), entry.entries});
+    names += entry.name;
+    ranges.insert(ranges.end(), entry.ranges.begin(), entry.ranges.end());
   }
-  std::filesystem::path locale_path = getLocalePath(locale);
-  if (!std::filesystem::exists(locale_path))
+  header.rangeCount = ranges.size();
+  header.namesSize = names.size();
+
+  // Same write-then-rename as compiled catalogs; failing to write the index only costs a rebuild next time
+  std::filesystem::path temp_path = indexPath;
+  temp_path += ".tmp";
   {
-    m_locale = m_defaultLocale;
-    m_dictionary.clear();
-    return;
+    std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(namespaces.data()), namespaces.size() * sizeof(index_namespace));
+    file.write(reinterpret_cast<const char*>(ranges.data()), ranges.size() * sizeof(range));
+    file.write(names.data(), names.size());
+    if (!file.good()) return;
   }
-  m_dictionary = parseDictionary(locale_path);
+  std::error_code ec;
+  std::filesystem::rename(temp_path, indexPath, ec);
 }
 
-inline std::filesystem::path i18n::getLocalePath(std::string locale)
+inline i18n::message i18n::lazy_index::find(std::uint64_t hash, std::string_view ns, std::string_view msgid, bool verifyText) const
 {
-  std::string locale_filename = locale + m_localeExtension;
-  return (m_localePath / locale_filename);
-}
\ No newline at end of file
+  const std::uint64_t nsHash = hashString(ns);
+  auto it = std::lower_bound(m_namespaces.begin(), m_namespaces.end(), nsHash, [](const ns_entry& entry, std::uint64_t value) { return entry.hash < value; });
+  for (; it != m_namespaces.end() && it->hash == nsHash; ++it)
+  {
+    if (it->name != ns) continue;
+    const std::size_t index = it - m_namespaces.begin();
+    const dictionary* loaded = m_loaded[index].load(std::memory_order_acquire);
+    return (loaded ? *loaded : load(index)).find(hash, ns, msgid, verifyText);
+  }
+  return {};
+}
+
+inline const i18n::dictionary& i18n::lazy_index::load(std::size_t index) const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (const dictionary* loaded = m_loaded[index].load(std::memory_order_acquire)) return *loaded; // Another thread was first
+  auto parsed = std::make_unique<dictionary>(m_arena, m_internText);
+  const std::string_view text(m_mapping->data(), m_mapping->size());
+  for (const range& r : m_namespaces[index].ranges) parseBuffer(text.substr(r.begin, r.end - r.begin), m_defaultNS, *parsed);
+  parsed->seal();
+  m_loaded[index].store(parsed.get(), std::memory_order_release);
+  m_owned[index] = std::move(parsed);
+  return *m_owned[index];
+}
+
+inline std::size_t i18n::lazy_index::bytes() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  std::size_t total = 0;
+  for (std::size_t index = 0; index < m_namespaces.size(); ++index)
+  {
+    total += sizeof(ns_entry) + m_namespaces[index].name.size() + m_namespaces[index].ranges.size() * sizeof(range);
+    if (m_owned[index]) total += m_owned[index]->bytes();
+  }
+  return total;
+}
+
+inline std::size_t i18n::lazy_index::size() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  std::size_t total = 0;
+  for (const std::unique_ptr<const dictionary>& owned : m_owned)
+    if (owned) total += owned->size();
+  return total;
+}
+
+inline std::size_t i18n::lazy_index::indexedSize() const
+{
+  std::size_t total = 0;
+  for (const ns_entry& entry : m_namespaces) total += static_cast<std::size_t>(entry.entries);
+  return total;
+}
+
+inline std::size_t i18n::lazy_index::internedBytes() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  std::size_t total = 0;
+  for (const std::unique_ptr<const dictionary>& owned : m_owned)
+    if (owned) total += owned->internedBytes();
+  return total;
+}
+
+inline bool i18n::dictionary::attach(const char* data, std::size_t size, std::string_view defaultNS)
+{
+  file_header header {};
+  if (size < fileHeaderSizeV1) return false;
+  std::memcpy(&header, data, fileHeaderSizeV1);
+  if (std::memcmp(header.magic, fileMagic, sizeof(header.magic)) || header.version < 1 || header.version > fileVersion || header.byteOrder != 0x01020304) return false;
+  const std::size_t headerSize = header.version == 1 ? fileHeaderSizeV1 : sizeof(header); // Version 1 has no perfect hash
+  if (size < headerSize) return false;
+  std::memcpy(&header, data, headerSize);
+  if (header.stringsSize > UINT32_MAX || header.slotCount > size || header.formatCount > size || header.bucketCount > size) return false;
+  if (header.bucketCount ? header.slotCount != header.size : (header.slotCount & (header.slotCount - 1) || header.size > header.slotCount)) return false;
+  if (size != headerSize + header.slotCount * sizeof(slot) + header.formatCount * sizeof(format_segment) + header.bucketCount * sizeof(std::uint32_t) + header.stringsSize) return false;
+  if (reinterpret_cast<std::uintptr_t>(data) % alignof(slot)) return false;
+
+  view view;
+  const char* at = data + headerSize;
+  view.slots = reinterpret_cast<const slot*>(at);
+  view.slotCount = header.slotCount;
+  at += header.slotCount * sizeof(slot);
+  view.format = reinterpret_cast<const format_segment*>(at);
+  view.formatCount = header.formatCount;
+  at += header.formatCount * sizeof(format_segment);
+  view.displacements = reinterpret_cast<const std::uint32_t*>(at);
+  view.bucketCount = header.bucketCount;
+  at += header.bucketCount * sizeof(std::uint32_t);
+  view.strings = at;
+  view.stringsSize = header.stringsSize;
+  m_view = view;
+  if (!inStrings(header.defaultNS, header.defaultNSLen) || std::string_view(view.strings + header.defaultNS, header.defaultNSLen) != defaultNS) return false;
+  m_size = header.size;
+  return true;
+}
+
+inline std::uint32_t i18n::dictionary::addString(std::string_view str)
+{
+  std::pmr::string& strings = m_storage.strings;
+  std::uint32_t offset = static_cast<std::uint32_t>(strings.size());
+  strings.append(str);
+  strings.push_back('\0');
+  return offset;
+}
+
+inline std::uint32_t i18n::dictionary::internString(std::string_view str)
+{
+  if ((m_internedCount + 1) * 2 > m_interned.size()) // Under 1/2 full, most probes end at the first entry
+  {
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> interned(m_interned.empty() ? 64 : m_interned.size() * 2);
+    const std::size_t mask = interned.size() - 1;
+    for (const auto& entry : m_interned)
+    {
+      if (!entry.second) continue;
+      std::size_t i = entry.first & mask;
+      while (interned[i].second) i = (i + 1) & mask;
+      interned[i] = entry;
+    }
+    m_interned.swap(interned);
+  }
+
+  const std::uint64_t wide = hashString(str);
+  const std::uint32_t hash = static_cast<std::uint32_t>(wide ^ (wide >> 32));
+  const std::pmr::string& strings = m_storage.strings;
+  const std::size_t mask = m_interned.size() - 1;
+  std::size_t i = hash & mask;
+  for (; m_interned[i].second; i = (i + 1) & mask)
+  {
+    if (m_interned[i].first != hash) continue;
+    const std::uint32_t offset = m_interned[i].second - 1;
+    if (strings.compare(offset, str.size(), str) == 0 && strings[offset + str.size()] == '\0') // Not just a prefix of a longer string
+    {
+      m_internedBytes += str.size() + 1;
+      return offset;
+    }
+  }
+  const std::uint32_t offset = addString(str);
+  m_interned[i] = {hash, offset + 1};
+  ++m_internedCount;
+  return offset;
+}
+
+inline void i18n::dictionary::seal()
+{
+  m_interned = {};
+  m_internedCount = 0;
+}
+
+inline void i18n::dictionary::compileFormat(slot& slot)
+{
+  slot.format = slot.formatLen = 0;
+  const std::string_view text(&m_storage.strings[slot.msgstr], slot.msgstrLen);
+  auto nextBrace = [&text](std::size_t from) { return std::min(text.find('{', from), text.find('}', from)); }; // Two memchr beat a byte loop
+  if (nextBrace(0) == std::string_view::npos) return; // Nothing to parse
+
+  // Split msgstr into literal text and replacement fields, appending straight to the segment table and
+  // dropping them again on failure. Anything this doesn't understand (named or nested arguments,
+  // malformed fields) is left to vformat, which reports the error as before.
+  std::pmr::vector<format_segment>& segments = m_storage.format;
+  const std::size_t first = segments.size();
+  bool automatic = false, manual = false;
+  std::int32_t nextArg = 0;
+  std::size_t literal = 0;
+  auto addLiteral = [&](std::size_t begin, std::size_t end) {
+    if (end > begin) segments.push_back({static_cast<std::uint32_t>(slot.msgstr + begin), static_cast<std::uint32_t>(end - begin), -1, format_segment::LITERAL, 0});
+  };
+  auto abandon = [&] { segments.resize(first); };
+  for (std::size_t i = 0; (i = nextBrace(i)) != std::string_view::npos;)
+  {
+    if (i + 1 < text.size() && text[i + 1] == text[i]) // Escaped brace, keep one of them
+    {
+      addLiteral(literal, i + 1);
+      i += 2;
+      literal = i;
+      continue;
+    }
+    if (text[i] == '}') return abandon();
+    addLiteral(literal, i);
+    std::size_t j = i + 1;
+    std::int32_t arg = 0;
+    if (j < text.size() && text[j] >= '0' && text[j] <= '9')
+    {
+      for (; j < text.size() && text[j] >= '0' && text[j] <= '9'; ++j) arg = arg * 10 + (text[j] - '0');
+      manual = true;
+    }
+    else
+    {
+      arg = nextArg++;
+      automatic = true;
+    }
+    const std::size_t close = text.find('}', j);
+    if (close == std::string_view::npos || (text[j] != ':' && text[j] != '}')) return abandon();
+    const std::string_view spec = text.substr(j, close - j);
+    if (spec.find('{') != std::string_view::npos) return abandon();
+    // Until the field strings are written below, offset and length point at the spec inside msgstr
+    format_segment segment {static_cast<std::uint32_t>(slot.msgstr + j), static_cast<std::uint32_t>(spec.size()), arg, format_segment::FIELD, 0};
+    if (spec.empty() || spec == ":") segment.kind = format_segment::DEFAULT;
+    else if (spec.size() >= 4 && spec.size() <= 5 && spec[1] == '.' && spec.back() == 'f' && spec.find_first_not_of("0123456789", 2) == spec.size() - 1)
+    {
+      segment.kind = format_segment::FIXED;
+      segment.precision = static_cast<std::uint16_t>(spec[2] - '0');
+      if (spec.size() == 5) segment.precision = static_cast<std::uint16_t>(segment.precision * 10 + spec[3] - '0');
+    }
+    segments.push_back(segment);
+    i = close + 1;
+    literal = i;
+  }
+  addLiteral(literal, text.size());
+  if (automatic && manual) return abandon();
+  // Fields without a fast path are formatted one vformat call each, which is slower than one call
+  // for the whole msgstr, so the split only pays off when some field skips the formatter
+  if (std::none_of(segments.begin() + first, segments.end(), [](const format_segment& segment) { return segment.kind == format_segment::DEFAULT || segment.kind == format_segment::FIXED; }))
+    return abandon();
+
+  std::pmr::string& strings = m_storage.strings;
+  for (std::size_t index = first; index < segments.size(); ++index) // Appending may reallocate the strings, so text is not used past here
+  {
+    format_segment& segment = segments[index];
+    if (segment.kind == format_segment::LITERAL) continue;
+    const std::uint32_t offset = static_cast<std::uint32_t>(strings.size());
+    char arg[16];
+    strings.push_back('{');
+    strings.append(arg, std::to_chars(arg, arg + sizeof(arg), segment.arg).ptr);
+    strings.append(strings, segment.offset, segment.length);
+    strings.push_back('}');
+    segment.length = static_cast<std::uint32_t>(strings.size() - offset);
+    segment.offset = offset;
+    strings.push_back('\0');
+  }
+  slot.format = static_cast<std::uint32_t>(first);
+  slot.formatLen = static_cast<std::uint32_t>(segments.size() - first);
+}
+
+inline bool i18n::dictionary::inBounds(const slot& s) const
+{
+  if (!inStrings(s.ns, s.nsLen) || !inStrings(s.msgid, s.msgidLen) || !inStrings(s.msgstr, s.msgstrLen) || std::uint64_t(s.format) + s.formatLen > m_view.formatCount) return false;
+  for (std::uint32_t segment = 0; segment < s.formatLen; ++segment)
+    if (!inStrings(m_view.format[s.format + segment].offset, m_view.format[s.format + segment].length)) return false;
+  return true;
+}
+
+inline std::shared_ptr<const i18n::resolved_table> i18n::resolved_table::build(std::vector<std::shared_ptr<const dictionary>> sources)
+{
+  auto table = std::make_shared<resolved_table>();
+  std::size_t entries = 0;
+  for (std::shared_ptr<const dictionary>& source : sources)
+  {
+    if (!source) continue;
+    if (source->m_lazy) return nullptr;
+    entries += source->size();
+    table->m_sources.push_back(std::move(source));
+  }
+  std::size_t capacity = 16;
+  while (entries * 4 > capacity * 3) capacity *= 2;
+  table->m_entries.assign(capacity, entry{});
+
+  const std::size_t mask = capacity - 1;
+  for (std::uint32_t index = 0; index < table->m_sources.size(); ++index)
+  {
+    const dictionary& source = *table->m_sources[index];
+    for (std::size_t slot = 0; slot < source.m_view.slotCount; ++slot)
+    {
+      const dictionary::slot& s = source.m_view.slots[slot];
+      if (!s.hash || !source.inBounds(s)) continue; // Damaged entries of a mapped catalog are checked once, here
+      const std::string_view ns(source.m_view.strings + s.ns, s.nsLen), msgid(source.m_view.strings + s.msgid, s.msgidLen);
+      std::size_t i = s.hash & mask;
+      bool taken = false;
+      for (; table->m_entries[i].slot.hash; i = (i + 1) & mask)
+      {
+        const entry& e = table->m_entries[i];
+        if (e.slot.hash != s.hash) continue;
+        const char* strings = table->m_sources[e.source]->m_view.strings;
+        if (std::string_view(strings + e.slot.msgid, e.slot.msgidLen) == msgid && std::string_view(strings + e.slot.ns, e.slot.nsLen) == ns)
+        {
+          taken = true; // By a source earlier in the chain
+          break;
+        }
+      }
+      if (!taken) table->m_entries[i] = {s, index};
+    }
+  }
+  return table;
+}
+
+inline i18n::message i18n::resolved_table::find(std::uint64_t hash, std::string_view ns, std::string_view msgid, bool verifyText) const
+{
+  const std::size_t mask = m_entries.size() - 1;
+  for (std::size_t i = hash & mask; m_entries[i].slot.hash; i = (i + 1) & mask) // The load factor keeps an empty entry to stop at
+  {
+    const entry& e = m_entries[i];
+    if (e.slot.hash != hash) continue;
+    const dictionary::view& source = m_sources[e.source]->m_view;
+    const dictionary::slot& s = e.slot;
+    const message found {std::string_view(source.strings + s.msgstr, s.msgstrLen), s.formatLen ? source.format + s.format : nullptr, s.formatLen, source.strings};
+#ifdef NDEBUG
+    if (!verifyText) return found;
+#endif
+    if (std::string_view(source.strings + s.msgid, s.msgidLen) == msgid && std::string_view(source.strings + s.ns, s.nsLen) == ns)
+      return found;
+    assert(verifyText && "i18n: hash collision between a compile-time key and a different catalog entry");
+  }
+  return {};
+}
+
+inline std::size_t i18n::dictionary::bytes() const
+{
+  return m_view.slotCount * sizeof(slot) + m_view.formatCount * sizeof(format_segment) + m_view.bucketCount * sizeof(std::uint32_t) + m_view.stringsSize + (m_lazy ? m_lazy->bytes() : 0);
+}
+
+inline std::size_t i18n::dictionary::size() const
+{
+  return m_lazy ? m_lazy->size() : m_size;
+}
+
+inline std::size_t i18n::dictionary::indexedSize() const
+{
+  return m_lazy ? m_lazy->indexedSize() : 0;
+}
+
+inline std::size_t i18n::dictionary::internedBytes() const
+{
+  return m_lazy ? m_lazy->internedBytes() : m_internedBytes;
+}
+
+inline bool i18n::dictionary::sameEntries(const dictionary& other) const
+{
+  if (m_lazy || other.m_lazy) return false; // Would have to parse every namespace to tell
+  if (m_size != other.m_size) return false;
+  for (std::size_t index = 0; index < other.m_view.slotCount; ++index)
+  {
+    const slot& s = other.m_view.slots[index];
+    if (!s.hash) continue;
+    if (!other.inStrings(s.ns, s.nsLen) || !other.inStrings(s.msgid, s.msgidLen) || !other.inStrings(s.msgstr, s.msgstrLen)) return false;
+    const char* strings = other.m_view.strings;
+    const message found = find(s.hash, std::string_view(strings + s.ns, s.nsLen), std::string_view(strings + s.msgid, s.msgidLen));
+    if (!found.msgstr.data() || found.msgstr != std::string_view(strings + s.msgstr, s.msgstrLen)) return false;
+  }
+  return true;
+}
+
+inline void i18n::dictionary::merge(const dictionary& other)
+{
+  assert(!m_mapping && !m_view.bucketCount && "i18n: mapped and compiled dictionaries are read-only");
+  // Strings go through the interning table as insert() stores them, so the result is the same as parsing
+  // in one pass. Namespaces always do, the few per file are remembered by their offset in other. Without
+  // m_internText the other strings and segments are appended as they are and only their offsets shifted.
+  // With it each entry's strings are interned in file order, literal segments follow their msgstr and
+  // field strings are copied.
+  const std::uint32_t stringsBase = static_cast<std::uint32_t>(m_storage.strings.size());
+  const std::uint32_t formatBase = static_cast<std::uint32_t>(m_storage.format.size());
+  reserve(m_size + other.m_size, m_storage.strings.size() + other.m_view.stringsSize);
+  if (!m_internText)
+  {
+    m_storage.strings.append(other.m_view.strings ? other.m_view.strings : "", other.m_view.stringsSize);
+    m_storage.format.reserve(m_storage.format.size() + other.m_view.formatCount);
+    for (std::size_t segment = 0; segment < other.m_view.formatCount; ++segment)
+    {
+      m_storage.format.push_back(other.m_view.format[segment]);
+      m_storage.format.back().offset += stringsBase;
+    }
+  }
+
+  std::vector<std::uint64_t> order; // msgid offset, then slot index
+  order.reserve(other.m_size);
+  for (std::uint32_t index = 0; index < other.m_view.slotCount; ++index)
+    if (other.m_view.slots[index].hash) order.push_back(std::uint64_t(other.m_view.slots[index].msgid) << 32 | index);
+  if (m_internText) std::sort(order.begin(), order.end()); // Reads other's strings front to back
+
+  auto text = [&other](std::uint32_t offset, std::uint32_t length) { return std::string_view(other.m_view.strings + offset, length); };
+  std::unordered_map<std::uint32_t, std::uint32_t> namespaces; // Other's offset to ours
+  std::pmr::vector<slot>& slots = m_storage.slots;
+  for (std::size_t at = 0; at < order.size(); ++at)
+  {
+    if (at + 8 < order.size()) prefetch(other.m_view.slots[static_cast<std::uint32_t>(order[at + 8])].hash);
+    const slot& from = other.m_view.slots[static_cast<std::uint32_t>(order[at])];
+    const std::string_view ns = text(from.ns, from.nsLen), msgid = text(from.msgid, from.msgidLen);
+    if ((m_size + 1) * 4 > slots.size() * 3) grow(slots.size() * 2);
+    const std::size_t mask = slots.size() - 1;
+    std::size_t i = from.hash & mask;
+    for (; slots[i].hash; i = (i + 1) & mask)
+    {
+      const slot& s = slots[i];
+      if (s.hash == from.hash && std::string_view(&m_storage.strings[s.ns], s.nsLen) == ns && std::string_view(&m_storage.strings[s.msgid], s.msgidLen) == msgid) break;
+    }
+
+    slot added = from;
+    if (slots[i].hash) // A later definition only replaces the msgstr
+    {
+      added.ns = slots[i].ns;
+      added.msgid = slots[i].msgid;
+    }
+    else
+    {
+      auto [known, first] = namespaces.try_emplace(from.ns, 0);
+      if (first) known->second = internString(ns);
+      else m_internedBytes += ns.size() + 1; // What internString would have counted
+      added.ns = known->second;
+      added.msgid = m_internText ? internString(msgid) : from.msgid + stringsBase;
+      ++m_size;
+    }
+    if (!m_internText)
+    {
+      added.msgstr += stringsBase;
+      if (added.formatLen) added.format += formatBase;
+    }
+    else
+    {
+      added.msgstr = internString(text(from.msgstr, from.msgstrLen));
+      added.format = added.formatLen ? static_cast<std::uint32_t>(m_storage.format.size()) : 0;
+      for (std::uint32_t segment = 0; segment < from.formatLen; ++segment)
+      {
+        format_segment copied = other.m_view.format[from.format + segment];
+        if (copied.kind == format_segment::LITERAL) copied.offset = copied.offset - from.msgstr + added.msgstr;
+        else copied.offset = addString(text(copied.offset, copied.length));
+        m_storage.format.push_back(copied);
+      }
+    }
+    slots[i] = added;
+  }
+  rebind();
+}
+
+inline void i18n::dictionary::reserve(std::size_t entries, std::size_t stringBytes)
+{
+  assert(!m_mapping && "i18n: mapped dictionaries are read-only");
+  std::size_t capacity = m_storage.slots.empty() ? 16 : m_storage.slots.size();
+  while (entries * 4 > capacity * 3) capacity *= 2;
+  if (capacity > m_storage.slots.size()) grow(capacity);
+  m_storage.strings.reserve(stringBytes);
+  rebind();
+}
+
+inline void i18n::dictionary::grow(std::size_t capacity)
+{
+  std::pmr::vector<slot> slots(capacity, slot{}, m_storage.slots.get_allocator()); // Same resource, so swapping is allowed
+  const std::size_t mask = slots.size() - 1;
+  for (const slot& s : m_storage.slots)
+  {
+    if (!s.hash) continue;
+    std::size_t i = s.hash & mask;
+    while (slots[i].hash) i = (i + 1) & mask;
+    slots[i] = s;
+  }
+  m_storage.slots.swap(slots);
+}
@@ -0,0 +1,95 @@
+// Converts text .locale files into compiled catalogs that i18n::Init / i18n::SetLocale load without parsing.
+//
+// Usage: locale-compiler [--default-ns <namespace>] [--embed] <file.locale> [<output>]
+//
+// The output defaults to the input path with a trailing "c" (zh-CN.locale -> zh-CN.localec), which is
+// where the library looks for it. --default-ns must match the defaultNS passed to i18n::Init.
+//
+// With --embed the output is a C++ header instead (zh-CN.locale -> zh-CN.locale.h) holding the compiled
+// catalog as a constexpr array, registered with i18n::RegisterEmbeddedCatalog under the file's name.
+// Including it in one source file links the locale into the program. See the i18n.embed xmake rule.
+
+#include <i18n/i18n.h>
+#include <cctype>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+// Writes the compiled catalog image as a header. The array is aligned for the slot table, so the
+// library reads it in place.
+static bool writeEmbedded(const std::filesystem::path& destination, const std::string& locale, const std::string& image)
+{
+    std::string name = "catalog_";
+    for (char c : locale)
+        name += std::isalnum(static_cast<unsigned char>(c)) ? c : '_';
+
+    std::string header;
+    header += "// Generated by locale-compiler --embed, do not edit.\n";
+    header += "#pragma once\n#include <i18n/i18n.h>\n\nnamespace i18n_embedded\n{\n";
+    header += "  alignas(8) inline constexpr unsigned char " + name + "[] = {";
+    for (std::size_t i = 0; i < image.size(); ++i)
+    {
+        if (i % 24 == 0) header += "\n    ";
+        header += std::to_string(static_cast<unsigned char>(image[i]));
+        header += ',';
+    }
+    header += "\n  };\n";
+    header += "  inline const bool " + name + "_registered = i18n::RegisterEmbeddedCatalog(\"" + locale + "\", std::string_view(reinterpret_cast<const char*>(" + name + "), sizeof(" + name + ")));\n";
+    header += "}\n";
+
+    std::ofstream file(destination, std::ios::binary | std::ios::trunc);
+    file << header;
+    return static_cast<bool>(file);
+}
+
+int main(int argc, char** argv)
+{
+    std::string defaultNS = "default";
+    std::filesystem::path source, destination;
+    bool embed = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--default-ns" && i + 1 < argc)
+            defaultNS = argv[++i];
+        else if (arg == "--embed")
+            embed = true;
+        else if (source.empty())
+            source = arg;
+        else if (destination.empty())
+            destination = arg;
+        else
+            source.clear(); // Too many arguments
+    }
+    if (source.empty())
+    {
+        fprintf(stderr, "Usage: locale-compiler [--default-ns <namespace>] [--embed] <file.locale> [<output>]\n");
+        return 1;
+    }
+    if (destination.empty())
+        destination = source.string() + (embed ? ".h" : "c");
+
+    i18n::SetStringInterning(true); // Parse time doesn't matter here, smaller catalogs do
+    const std::filesystem::path compiled = embed ? std::filesystem::path(destination.string() + ".tmp") : destination;
+    if (!i18n::CompileLocale(source, compiled, defaultNS))
+    {
+        fprintf(stderr, "locale-compiler: failed to compile %s\n", source.string().c_str());
+        return 1;
+    }
+    if (embed)
+    {
+        std::ifstream file(compiled, std::ios::binary);
+        const std::string image((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        file.close();
+        std::error_code ec;
+        std::filesystem::remove(compiled, ec);
+        if (!writeEmbedded(destination, source.stem().string(), image))
+        {
+            fprintf(stderr, "locale-compiler: failed to write %s\n", destination.string().c_str());
+            return 1;
+        }
+    }
+    printf("%s -> %s\n", source.string().c_str(), destination.string().c_str());
+    return 0;
+}
@@ -0,0 +1,431 @@
+// Scans sources for translated literals and assigns each (namespace, msgid) a dense message ID.
+//
+// Usage: message-extractor [--namespace <name>] [--default-ns <namespace>] [--output <header>] <file or directory>...
+//
+// Every Translate*, TranslateN* and I18N / I18N_N call whose msgid (and namespace) are string literals is
+// collected. The output header (messages.h by default) declares one i18n::message_id constant per message
+// in the C++ namespace given by --namespace ("messages" by default), and the table of keys in ID order,
+// registered with i18n::RegisterMessageTable. Include it in one source file, then
+//
+//     i18n::TranslateView(messages::Hello_world);
+//
+// is an array index into the active locale. Messages are told apart by the value of their literals, so
+// "a" "b" and "ab" are one message, and so are a call without a namespace and one naming --default-ns
+// (which must match the defaultNS passed to i18n::Init). IDs are assigned in (namespace, msgid) order,
+// so they only depend on which messages exist, not on where they are used.
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct message
+{
+    std::string ns; // Value of the namespace literal, the default namespace for calls without one
+    std::string msgid; // Value of the msgid literal(s): escapes resolved and adjacent literals joined
+    bool explicitNS = false; // The first call seen named the namespace
+
+    bool operator<(const message& other) const { return ns != other.ns ? ns < other.ns : msgid < other.msgid; }
+};
+
+// Argument index of the msgid for each call, and whether a namespace argument comes right before it
+struct call
+{
+    std::size_t msgid;
+    bool withNS;
+};
+
+static const std::map<std::string, call, std::less<>> s_calls = {
+    {"Translate", {0, false}}, {"TranslateView", {0, false}}, {"TranslateTo", {1, false}}, {"TranslateToBuffer", {1, false}}, {"I18N", {0, false}},
+    {"TranslateN", {1, true}}, {"TranslateNView", {1, true}}, {"TranslateNTo", {2, true}}, {"TranslateNToBuffer", {2, true}}, {"I18N_N", {1, true}},
+};
+
+static bool isIdentifier(char c)
+{
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
+
+// Skips whitespace and comments from `at`
+static std::size_t skipSpace(std::string_view text, std::size_t at)
+{
+    while (at < text.size())
+    {
+        if (std::isspace(static_cast<unsigned char>(text[at])))
+            ++at;
+        else if (text.substr(at, 2) == "//")
+            at = std::min(text.find('\n', at), text.size());
+        else if (text.substr(at, 2) == "/*")
+            at = std::min(text.find("*/", at + 2), text.size() - 2) + 2;
+        else
+            break;
+    }
+    return at;
+}
+
+// If a string literal starts at `at`, returns one past its end (and past a _i18n suffix), otherwise `at`
+static std::size_t skipLiteral(std::string_view text, std::size_t at)
+{
+    std::size_t begin = at;
+    if (text.substr(at, 2) == "u8") at += 2;
+    if (at < text.size() && text[at] == 'R' && at + 1 < text.size() && text[at + 1] == '"')
+    {
+        const std::size_t open = text.find('(', at);
+        if (open == std::string_view::npos) return begin;
+        const std::string terminator = ")" + std::string(text.substr(at + 2, open - at - 2)) + "\"";
+        const std::size_t close = text.find(terminator, open);
+        return close == std::string_view::npos ? text.size() : close + terminator.size();
+    }
+    if (at >= text.size() || text[at] != '"') return begin;
+    for (++at; at < text.size() && text[at] != '"' && text[at] != '\n'; ++at)
+        if (text[at] == '\\') ++at;
+    at = std::min(at + 1, text.size());
+    if (text.substr(at, 5) == "_i18n") at += 5;
+    return at;
+}
+
+static void appendUtf8(std::string& out, std::uint32_t cp)
+{
+    if (cp < 0x80)
+        out += static_cast<char>(cp);
+    else if (cp < 0x800)
+    {
+        out += static_cast<char>(0xc0 | (cp >> 6));
+        out += static_cast<char>(0x80 | (cp & 0x3f));
+    }
+    else if (cp < 0x10000)
+    {
+        out += static_cast<char>(0xe0 | (cp >> 12));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+        out += static_cast<char>(0x80 | (cp & 0x3f));
+    }
+    else
+    {
+        out += static_cast<char>(0xf0 | (cp >> 18));
+        out += static_cast<char>(0x80 | ((cp >> 12) & 0x3f));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+        out += static_cast<char>(0x80 | (cp & 0x3f));
+    }
+}
+
+// Appends the value of one literal as skipLiteral delimits it (prefix, quotes and suffix included)
+static void appendValue(std::string& value, std::string_view literal)
+{
+    if (literal.size() > 5 && literal.substr(literal.size() - 5) == "_i18n") literal.remove_suffix(5);
+    if (literal.substr(0, 2) == "u8") literal.remove_prefix(2);
+    if (literal[0] == 'R') // R"delimiter(...)delimiter"
+    {
+        const std::size_t open = literal.find('(');
+        value += literal.substr(open + 1, literal.size() - 2 * open - 1); // The delimiter is open - 2 characters on both sides
+        return;
+    }
+    literal = literal.substr(1, literal.size() - 2);
+    for (std::size_t i = 0; i < literal.size(); ++i)
+    {
+        if (literal[i] != '\\' || i + 1 == literal.size())
+        {
+            value += literal[i];
+            continue;
+        }
+        const char c = literal[++i];
+        auto hexDigits = [&](std::size_t max) {
+            std::uint32_t cp = 0;
+            for (std::size_t n = 0; n < max && i + 1 < literal.size() && std::isxdigit(static_cast<unsigned char>(literal[i + 1])); ++n)
+            {
+                const char digit = literal[++i];
+                cp = cp * 16 + static_cast<std::uint32_t>(std::isdigit(static_cast<unsigned char>(digit)) ? digit - '0' : std::tolower(static_cast<unsigned char>(digit)) - 'a' + 10);
+            }
+            return cp;
+        };
+        switch (c)
+        {
+        case 'n': value += '\n'; break;
+        case 't': value += '\t'; break;
+        case 'r': value += '\r'; break;
+        case 'a': value += '\a'; break;
+        case 'b': value += '\b'; break;
+        case 'f': value += '\f'; break;
+        case 'v': value += '\v'; break;
+        case 'x': value += static_cast<char>(hexDigits(SIZE_MAX)); break;
+        case 'u': appendUtf8(value, hexDigits(4)); break;
+        case 'U': appendUtf8(value, hexDigits(8)); break;
+        default:
+            if (c >= '0' && c <= '7')
+            {
+                std::uint32_t code = c - '0';
+                for (std::size_t n = 1; n < 3 && i + 1 < literal.size() && literal[i + 1] >= '0' && literal[i + 1] <= '7'; ++n)
+                    code = code * 8 + (literal[++i] - '0');
+                value += static_cast<char>(code);
+            }
+            else
+                value += c; // \\ \' \" \?
+        }
+    }
+}
+
+// Reads an argument made only of literals ("a" "b" is one). Returns false for anything else.
+static bool readLiteral(std::string_view argument, std::string& value)
+{
+    value.clear();
+    bool found = false;
+    std::size_t at = skipSpace(argument, 0);
+    for (std::size_t end; (end = skipLiteral(argument, at)) != at; at = skipSpace(argument, end))
+    {
+        appendValue(value, argument.substr(at, end - at));
+        found = true;
+    }
+    return found && at == argument.size();
+}
+
+// An ordinary literal with the same bytes as value. Anything but printable ASCII is escaped, so a u8 or
+// non-ASCII literal in the sources doesn't depend on the execution character set (or char8_t) here.
+static std::string literal(std::string_view value)
+{
+    static const char digits[] = "01234567";
+    std::string out = "\"";
+    for (unsigned char c : value)
+    {
+        if (c == '"' || c == '\\') out += {'\\', static_cast<char>(c)};
+        else if (c == '\n') out += "\\n";
+        else if (c == '\t') out += "\\t";
+        else if (c >= 0x20 && c < 0x7f) out += static_cast<char>(c);
+        else out += {'\\', digits[c >> 6], digits[(c >> 3) & 7], digits[c & 7]}; // Octal stops after 3 digits, unlike \x
+    }
+    return out + "\"";
+}
+
+// Splits the argument list opening at `open` into its top-level arguments. Returns one past the closing parenthesis.
+static std::size_t readArguments(std::string_view text, std::size_t open, std::vector<std::string_view>& arguments)
+{
+    std::size_t begin = open + 1, at = begin;
+    for (int depth = 0; at < text.size(); ++at)
+    {
+        if (std::size_t end = skipLiteral(text, at); end != at)
+        {
+            at = end - 1;
+            continue;
+        }
+        const char c = text[at];
+        if (c == '\'' && !isIdentifier(text[at - 1])) // A character literal, unless it's a digit separator
+        {
+            for (++at; at < text.size() && text[at] != '\''; ++at)
+                if (text[at] == '\\') ++at;
+        }
+        else if (c == '(' || c == '[' || c == '{')
+            ++depth;
+        else if ((c == ')' || c == ']' || c == '}') && depth)
+            --depth;
+        else if (c == ',' && !depth)
+        {
+            arguments.push_back(text.substr(begin, at - begin));
+            begin = at + 1;
+        }
+        else if (c == ')')
+        {
+            arguments.push_back(text.substr(begin, at - begin));
+            return at + 1;
+        }
+    }
+    arguments.clear(); // Unbalanced
+    return at;
+}
+
+static void scan(std::string_view text, std::string_view defaultNS, std::set<message>& messages)
+{
+    std::vector<std::string_view> arguments;
+    for (std::size_t at = 0; at < text.size();)
+    {
+        if (std::size_t end = skipLiteral(text, at); end != at && (at == 0 || !isIdentifier(text[at - 1])))
+        {
+            at = end;
+            continue;
+        }
+        if (text[at] == '\'' && (at == 0 || !isIdentifier(text[at - 1]))) // A character literal, unless it's a digit separator
+        {
+            for (++at; at < text.size() && text[at] != '\''; ++at)
+                if (text[at] == '\\') ++at;
+            ++at;
+            continue;
+        }
+        if (std::size_t end = skipSpace(text, at); end != at)
+        {
+            at = end;
+            continue;
+        }
+        if (!isIdentifier(text[at]))
+        {
+            ++at;
+            continue;
+        }
+        std::size_t end = at;
+        while (end < text.size() && isIdentifier(text[end])) ++end;
+        const auto found = s_calls.find(text.substr(at, end - at));
+        at = end;
+        if (found == s_calls.end()) continue;
+        const std::size_t open = skipSpace(text, at);
+        if (open >= text.size() || text[open] != '(') continue; // A declaration or a function pointer
+
+        // Arguments are scanned again afterwards, a call may be nested in another one's arguments
+        arguments.clear();
+        readArguments(text, open, arguments);
+        const call& call = found->second;
+        if (arguments.size() <= call.msgid) continue;
+        message message;
+        if (!readLiteral(arguments[call.msgid], message.msgid)) continue; // Only IDs of literals are known up front
+        if (call.withNS)
+        {
+            if (!readLiteral(arguments[call.msgid - 1], message.ns)) continue;
+            message.explicitNS = true;
+        }
+        else
+            message.ns = defaultNS;
+        messages.insert(std::move(message));
+    }
+}
+
+// Names a generated constant can't take: keywords, and names the header itself refers to
+static const std::set<std::string, std::less<>> s_reserved = {
+    "alignas", "alignof", "and", "and_eq", "asm", "auto", "bitand", "bitor", "bool", "break", "case", "catch", "char",
+    "char8_t", "char16_t", "char32_t", "class", "compl", "concept", "const", "consteval", "constexpr", "constinit",
+    "const_cast", "continue", "co_await", "co_return", "co_yield", "decltype", "default", "delete", "do", "double",
+    "dynamic_cast", "else", "enum", "explicit", "export", "extern", "false", "float", "for", "friend", "goto", "if",
+    "inline", "int", "long", "mutable", "namespace", "new", "noexcept", "not", "not_eq", "nullptr", "operator", "or",
+    "or_eq", "private", "protected", "public", "register", "reinterpret_cast", "requires", "return", "short", "signed",
+    "sizeof", "static", "static_assert", "static_cast", "struct", "switch", "template", "this", "thread_local", "throw",
+    "true", "try", "typedef", "typeid", "typename", "union", "unsigned", "using", "virtual", "void", "volatile",
+    "wchar_t", "while", "xor", "xor_eq",
+    "i18n", "keys", "registered",
+};
+
+// A C++ identifier from the literal's text, e.g. "Hello, world!" -> Hello_world. Underscores are never
+// doubled or leading, which would make the name reserved.
+static std::string identifier(const message& message, std::string_view defaultNS)
+{
+    std::string name;
+    for (std::string_view text : {message.ns == defaultNS ? std::string_view() : std::string_view(message.ns), std::string_view(message.msgid)})
+    {
+        for (std::size_t i = 0; i < text.size() && name.size() < 48; ++i)
+        {
+            if (text[i] != '_' && isIdentifier(text[i]) && static_cast<unsigned char>(text[i]) < 0x80) name += text[i];
+            else if (!name.empty() && name.back() != '_') name += '_';
+        }
+        if (!name.empty() && name.back() != '_') name += '_';
+    }
+    while (!name.empty() && name.back() == '_') name.pop_back();
+    if (name.empty()) name = "message";
+    else if (std::isdigit(static_cast<unsigned char>(name[0]))) name = "message_" + name;
+    return name;
+}
+
+int main(int argc, char** argv)
+{
+    std::string cppNamespace = "messages";
+    std::string defaultNS = "default";
+    std::filesystem::path output = "messages.h";
+    std::vector<std::filesystem::path> inputs;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--namespace" && i + 1 < argc)
+            cppNamespace = argv[++i];
+        else if (arg == "--default-ns" && i + 1 < argc)
+            defaultNS = argv[++i];
+        else if (arg == "--output" && i + 1 < argc)
+            output = argv[++i];
+        else
+            inputs.push_back(arg);
+    }
+    if (inputs.empty())
+    {
+        fprintf(stderr, "Usage: message-extractor [--namespace <name>] [--default-ns <namespace>] [--output <header>] <file or directory>...\n");
+        return 1;
+    }
+
+    std::vector<std::filesystem::path> files;
+    for (const std::filesystem::path& input : inputs)
+    {
+        std::error_code ec;
+        if (!std::filesystem::is_directory(input, ec))
+        {
+            files.push_back(input);
+            continue;
+        }
+        for (const auto& entry : std::filesystem::recursive_directory_iterator(input, ec))
+        {
+            const std::string extension = entry.path().extension().string();
+            if (entry.is_regular_file() && (extension == ".cpp" || extension == ".cc" || extension == ".cxx" || extension == ".h" || extension == ".hpp" || extension == ".inl"))
+                files.push_back(entry.path());
+        }
+    }
+    std::sort(files.begin(), files.end());
+
+    std::set<message> messages;
+    for (const std::filesystem::path& file : files)
+    {
+        std::error_code ec;
+        if (std::filesystem::equivalent(file, output, ec)) continue; // Don't scan our own output
+        std::ifstream stream(file, std::ios::binary);
+        if (!stream)
+        {
+            fprintf(stderr, "message-extractor: can't read %s\n", file.string().c_str());
+            return 1;
+        }
+        const std::string text((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+        scan(text, defaultNS, messages);
+    }
+
+    std::string header;
+    header += "// Generated by message-extractor, do not edit.\n";
+    header += "#pragma once\n#include <i18n/i18n.h>\n\nnamespace " + cppNamespace + "\n{\n";
+    std::set<std::string, std::less<>> used = s_reserved;
+    for (std::size_t begin = 0, end; begin <= cppNamespace.size(); begin = end + 2) // "game::ui" reserves game and ui
+    {
+        end = std::min(cppNamespace.find("::", begin), cppNamespace.size());
+        used.insert(cppNamespace.substr(begin, end - begin));
+    }
+    std::size_t id = 0;
+    for (const message& message : messages)
+    {
+        // A taken name gets the first free number: "Hello 2", "Hello!" and "Hello?" are Hello_2, Hello, Hello_3
+        const std::string base = identifier(message, defaultNS);
+        std::string name = base;
+        for (int count = 2; used.count(name); ++count) name = base + "_" + std::to_string(count);
+        used.insert(name);
+        header += "  inline constexpr i18n::message_id " + name + " {" + std::to_string(id++) + "}; // ";
+        header += message.explicitNS ? literal(message.ns) + ", " + literal(message.msgid) : literal(message.msgid);
+        header += "\n";
+    }
+    header += "\n  // keys[id] is the message with that ID\n";
+    header += "  inline constexpr i18n::key keys[] = {\n";
+    for (const message& message : messages)
+        header += "    i18n::key(" + (message.explicitNS ? literal(message.ns) + ", " : "") + literal(message.msgid) + "),\n";
+    if (messages.empty()) header += "    i18n::key(\"\"),\n"; // No empty arrays
+    header += "  };\n";
+    header += "  inline const bool registered = i18n::RegisterMessageTable(keys);\n";
+    header += "}\n";
+
+    // Leave the file alone if nothing changed, so sources including it aren't rebuilt
+    std::ifstream current(output, std::ios::binary);
+    if (current && std::string((std::istreambuf_iterator<char>(current)), std::istreambuf_iterator<char>()) == header)
+    {
+        printf("%s: %zu messages, unchanged\n", output.string().c_str(), messages.size());
+        return 0;
+    }
+    current.close();
+    std::ofstream file(output, std::ios::binary | std::ios::trunc);
+    file << header;
+    if (!file)
+    {
+        fprintf(stderr, "message-extractor: failed to write %s\n", output.string().c_str());
+        return 1;
+    }
+    printf("%s: %zu messages\n", output.string().c_str(), messages.size());
+    return 0;
+}
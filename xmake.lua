@@ -6,6 +6,35 @@ add_requires("glfw", "glew", "imgui")
 
 add_defines("UNICODE")
 
+if is_plat("linux") then
+    add_syslinks("pthread") -- i18n::SetParseThreads
+end
+
+option("embed_locales")
+    set_default(false)
+    set_showmenu(true)
+    set_description("Link example/locales into the example instead of reading them at runtime")
+
+-- Compiles the .locale files added to a target into headers that embed them (locale-compiler --embed).
+-- zh-CN.locale becomes <autogendir>/i18n/zh-CN.locale.h, which is on the include path; including it in
+-- one source file registers the catalog with i18n::RegisterEmbeddedCatalog. The target needs
+-- add_deps("locale-compiler").
+rule("i18n.embed")
+    set_extensions(".locale")
+    on_load(function (target)
+        target:add("includedirs", path.join(target:autogendir(), "i18n"))
+    end)
+    before_buildcmd_file(function (target, batchcmds, sourcefile, opt)
+        local compiler = target:dep("locale-compiler")
+        local header = path.join(target:autogendir(), "i18n", path.filename(sourcefile) .. ".h")
+        batchcmds:show_progress(opt.progress, "${color.build.object}embedding %s", sourcefile)
+        batchcmds:mkdir(path.directory(header))
+        batchcmds:vrunv(compiler:targetfile(), {"--embed", path(sourcefile), path(header)})
+        batchcmds:add_depfiles(sourcefile, compiler:targetfile())
+        batchcmds:set_depmtime(os.mtime(header))
+        batchcmds:set_depcache(target:dependfile(header))
+    end)
+
 target("example")
     set_kind("binary")
     add_files("example/src/**.cpp")
@@ -13,7 +42,38 @@ target("example")
     add_packages("glfw", "glew", "imgui")
     add_includedirs("include")
 
+    if has_config("embed_locales") then
+        add_rules("i18n.embed")
+        add_files("example/locales/*.locale")
+        add_deps("locale-compiler")
+        add_defines("I18N_EMBED_LOCALES")
+    end
+
     on_package(function(target)
       os.rm("$(buildir)/windows/x64/release/locales")
       os.cp("example/locales", "$(buildir)/windows/x64/release/locales")
-    end)
\ No newline at end of file
+    end)
+
+-- Views held across SetLocaleAsync, headless so it can run under a sanitizer (see example/async/main.cpp)
+target("async-example")
+    set_kind("binary")
+    set_default(false)
+    add_files("example/async/*.cpp")
+    add_includedirs("include")
+    set_rundir("$(projectdir)")
+
+target("locale-compiler")
+    set_kind("binary")
+    add_files("tools/locale-compiler/*.cpp")
+    add_includedirs("include")
+
+target("message-extractor")
+    set_kind("binary")
+    add_files("tools/message-extractor/*.cpp")
+
+target("bench")
+    set_kind("binary")
+    set_default(false)
+    add_files("bench/src/*.cpp")
+    add_headerfiles("bench/src/*.h")
+    add_includedirs("include")